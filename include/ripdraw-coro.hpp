@@ -0,0 +1,387 @@
+/* ripdraw-coro.hpp
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * C++20 coroutine layer over ripdraw.hpp
+ * every command is an awaitable of an Executor, e.g. co_await executor.imageLoad("blue-on").
+ * A command is sent when it is awaited and its coroutine is resumed when the reply arrived,
+ * so coroutines written one command after the other still keep several commands in flight.
+ * The executor runs on one thread, commands in flight are kept in an RD_ASYNC_WINDOW.
+ */
+#ifndef _RIPDRAW_CORO_HPP_
+#define _RIPDRAW_CORO_HPP_
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ripdraw.hpp"
+
+namespace ripdraw
+{
+
+/* ================================================================== */
+/* coroutine run by an Executor, its return value is an error code, 0 on success */
+class Task
+{
+public:
+    struct promise_type
+    {
+        int result = 0;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(int value) { result = value; }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    Task(Task&& other) : handle_(other.handle_) { other.handle_ = nullptr; }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task()
+    {
+        if (handle_)
+        {
+            handle_.destroy();
+        }
+    }
+
+    bool done() const { return handle_.done(); }
+    int result() const { return handle_.promise().result; }
+    std::coroutine_handle<promise_type> handle() const { return handle_; }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+class Executor;
+
+/* ================================================================== */
+/* command not sent until awaited, the coroutine gets a Result of the command */
+template <class T> class Command
+{
+public:
+    /* call of the Rd_* command, made once to send and once more to complete it */
+    typedef std::function<int(RD_INTERFACE*, T&)> Call;
+
+    Command(Executor* executor, Call call, bool split) : executor_(executor), call_(std::move(call)), split_(split) {}
+
+    bool await_ready() const { return false; }
+    inline bool await_suspend(std::coroutine_handle<> waiter);
+    Result<T> await_resume()
+    {
+        if (error_ < 0)
+        {
+            return Result<T>::failure(error_);
+        }
+        return std::move(value_);
+    }
+
+private:
+    friend class Executor;
+    Executor* executor_;
+    Call call_;
+    /* single frame command, bulk writes are run directly */
+    bool split_;
+    T value_ {};
+    int error_ = 0;
+    std::coroutine_handle<> waiter_;
+};
+
+/* ================================================================== */
+/* runs tasks on one interface, commands of all tasks share the pipeline */
+class Executor
+{
+public:
+    /* window is the number of commands in flight, 0 takes max_pending of the interface */
+    explicit Executor(Interface& rd, int window = 0) : rd_interface_(rd.get())
+    {
+        RdAsyncWindowInit(rd_interface_, &window_, call, done, this);
+        if (window <= 0)
+        {
+            window = (rd_interface_ && rd_interface_->max_pending > 1) ? rd_interface_->max_pending : RD_MAX_PENDING;
+        }
+        window_.size = (window > RD_MAX_PENDING) ? RD_MAX_PENDING : window;
+        /* direct commands, e.g. of a handle released in a task, wait for the pipeline */
+        if (rd_interface_)
+        {
+            rd_interface_->async_flush = flush;
+            rd_interface_->async_context = this;
+        }
+    }
+    ~Executor()
+    {
+        if (rd_interface_)
+        {
+            rd_interface_->async_flush = NULL;
+            rd_interface_->async_context = NULL;
+        }
+    }
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /* task starts on the next run */
+    void spawn(Task&& task)
+    {
+        ready_.push_back(task.handle());
+        tasks_.push_back(std::move(task));
+    }
+    /* run until every task returned, returns first error of a task */
+    int run()
+    {
+        int ret = 0;
+        for (;;)
+        {
+            if (!ready_.empty())
+            {
+                std::coroutine_handle<> handle = ready_.front();
+                ready_.pop_front();
+                handle.resume();
+            }
+            else if (window_.count > 0)
+            {
+                RdAsyncWindowComplete(rd_interface_, &window_);
+            }
+            else
+            {
+                break;
+            }
+        }
+        for (const Task& task : tasks_)
+        {
+            if (ret == 0 && task.done() && task.result() < 0)
+            {
+                ret = task.result();
+            }
+        }
+        tasks_.clear();
+        return ret;
+    }
+
+    RD_INTERFACE* get() const { return rd_interface_; }
+
+    /* layer commands */
+    Command<int> setLayerEnable(RD_ID layer_id, bool enable)
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_SetLayerEnable(rd, layer_id, enable ? RD_TRUE : RD_FALSE); });
+    }
+    Command<int> setLayerOriginAndSize(RD_ID layer_id, RD_POSITION position, RD_SIZE size)
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_SetLayerOriginAndSize(rd, layer_id, position, size); });
+    }
+    Command<int> setLayerBackColor(RD_ID layer_id, RD_COLOR back_color)
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_SetLayerBackColor(rd, layer_id, back_color); });
+    }
+    Command<int> setLayerTransparency(RD_ID layer_id, RD_BYTE transparency_percentage)
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_SetLayerTransparency(rd, layer_id, transparency_percentage); });
+    }
+    Command<int> layerClear(RD_ID layer_id)
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_LayerClear(rd, layer_id); });
+    }
+    /* bulk write, pixels must stay valid until the coroutine is resumed */
+    Command<int> layerWriteRawPixels(RD_ID layer_id, RD_POSITION position, RD_SIZE pixel_size, const RD_COLOR* pixels)
+    {
+        return Command<int>(this, [=](RD_INTERFACE* rd, int&)
+            { return Rd_LayerWriteRawPixels(rd, layer_id, position, pixel_size, pixels); }, false);
+    }
+    Command<int> composeLayersToPage(RD_ID page_id)
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_ComposeLayersToPage(rd, page_id); });
+    }
+    Command<int> pageToScreen(RD_ID page_id)
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_PageToScreen(rd, page_id); });
+    }
+
+    /* image commands */
+    Command<Image> imageLoad(const char* image_label)
+    {
+        std::string label(image_label);
+        return created<RD_RESOURCE_IMAGE>([=](RD_INTERFACE* rd, RD_ID* id)
+            { return Rd_ImageLoad(rd, label.c_str(), id); });
+    }
+    Command<ImageWrite> imageWrite(RD_ID layer_id, RD_ID image_id, RD_POSITION position)
+    {
+        return created<RD_RESOURCE_IMAGE_WRITE>([=](RD_INTERFACE* rd, RD_ID* id)
+            { return Rd_ImageWrite(rd, layer_id, image_id, position, id); });
+    }
+    Command<int> imageMove(RD_ID image_write_id, RD_POSITION position)
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_ImageMove(rd, image_write_id, position); });
+    }
+    Command<ImageList> imageListLoad(const char* prefix, RD_UWORD index_start, RD_UWORD index_step, RD_UWORD index_count)
+    {
+        std::string label(prefix);
+        return created<RD_RESOURCE_IMAGE_LIST>([=](RD_INTERFACE* rd, RD_ID* id)
+            { return Rd_ImageListLoad(rd, label.c_str(), index_start, index_step, index_count, id); });
+    }
+    Command<ImageListWrite> imageListWrite(RD_ID layer_id, RD_POSITION position, RD_ID image_list_id, RD_UWORD image_index)
+    {
+        return created<RD_RESOURCE_IMAGE_LIST_WRITE>([=](RD_INTERFACE* rd, RD_ID* id)
+            { return Rd_ImageListWrite(rd, layer_id, position, image_list_id, image_index, id); });
+    }
+    Command<int> imageListReplace(RD_ID image_list_write_id, RD_UWORD image_index)
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_ImageListReplace(rd, image_list_write_id, image_index); });
+    }
+
+    /* text commands */
+    Command<Font> fontLoad(const char* font_label)
+    {
+        std::string label(font_label);
+        return created<RD_RESOURCE_FONT>([=](RD_INTERFACE* rd, RD_ID* id)
+            { return Rd_FontLoad(rd, label.c_str(), id); });
+    }
+    Command<StringWrite> stringWrite(RD_ID layer_id, RD_POSITION position, RD_ID font_id, RD_COLOR color,
+        RD_HDIRECTION hdirection, const char* data)
+    {
+        std::string text(data);
+        return created<RD_RESOURCE_STRING_WRITE>([=](RD_INTERFACE* rd, RD_ID* id)
+            { return Rd_StringWrite(rd, layer_id, position, font_id, color, hdirection, text.c_str(), id); });
+    }
+    Command<int> stringReplace(RD_ID string_write_id, const char* data)
+    {
+        std::string text(data);
+        return plain([=](RD_INTERFACE* rd) { return Rd_StringReplace(rd, string_write_id, text.c_str()); });
+    }
+    Command<CharacterWrite> characterWrite(RD_ID layer_id, RD_POSITION position, RD_ID font_id, RD_COLOR color, RD_BYTE c)
+    {
+        return created<RD_RESOURCE_CHARACTER_WRITE>([=](RD_INTERFACE* rd, RD_ID* id)
+            { return Rd_CharacterWrite(rd, layer_id, position, font_id, color, c, id); });
+    }
+    Command<int> characterReplace(RD_ID character_write_id, RD_BYTE c)
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_CharacterReplace(rd, character_write_id, c); });
+    }
+
+    /* touch map commands */
+    Command<Touch> touchMapRectangle(RD_POSITION position, RD_SIZE size, const char* touch_label)
+    {
+        std::string label(touch_label);
+        return created<RD_RESOURCE_TOUCH>([=](RD_INTERFACE* rd, RD_ID* id)
+            { return Rd_TouchMapRectangle(rd, position, size, label.c_str(), id); });
+    }
+
+    /* other commands */
+    Command<std::string> systemInfo(RD_GET_VERSION_TYPE type)
+    {
+        return Command<std::string>(this, [=](RD_INTERFACE* rd, std::string& value)
+        {
+            const char* data;
+            int length;
+            int ret = Rd_SystemInfoView(rd, type, &data, &length);
+            if (ret == 0)
+            {
+                value.assign(data, length);
+            }
+            return ret;
+        }, true);
+    }
+    Command<int> reset()
+    {
+        return plain([=](RD_INTERFACE* rd) { return Rd_Reset(rd); });
+    }
+
+private:
+    template <class T> friend class Command;
+
+    Command<int> plain(std::function<int(RD_INTERFACE*)> call)
+    {
+        return Command<int>(this, [call](RD_INTERFACE* rd, int&) { return call(rd); }, true);
+    }
+    template <RD_RESOURCE_TYPE Type> Command<Handle<Type> > created(std::function<int(RD_INTERFACE*, RD_ID*)> call)
+    {
+        return Command<Handle<Type> >(this, [call](RD_INTERFACE* rd, Handle<Type>& value)
+        {
+            RD_ID id = 0;
+            int ret = call(rd, &id);
+            if (ret == 0)
+            {
+                value = Handle<Type>(rd, id);
+            }
+            return ret;
+        }, true);
+    }
+
+    /* send command of an awaiting coroutine, false when it is finished already */
+    template <class T> bool send(Command<T>* command)
+    {
+        int ret, slot = 0;
+        if (!command->split_)
+        {
+            /* bulk writes fragment into several frames, they are run alone */
+            RdAsyncWindowDrain(rd_interface_, &window_);
+            command->error_ = command->call_(rd_interface_, command->value_);
+            return false;
+        }
+        /* a slot is taken before the oldest command is completed to make room */
+        while (slots_[slot].call)
+        {
+            slot++;
+        }
+        slots_[slot].call = [command](RD_INTERFACE* rd) { return command->call_(rd, command->value_); };
+        slots_[slot].done = [this, command](int ret)
+        {
+            command->error_ = ret;
+            ready_.push_back(command->waiter_);
+        };
+        ret = RdAsyncWindowSend(rd_interface_, &window_, slot);
+        if (ret < 0)
+        {
+            slots_[slot] = Slot();
+            command->error_ = ret;
+            return false;
+        }
+        return true;
+    }
+    /* Rd_* call of a slot in the current phase */
+    static int call(RD_INTERFACE* rd, void* context, int slot)
+    {
+        return static_cast<Executor*>(context)->slots_[slot].call(rd);
+    }
+    /* resume coroutine of a completed slot on the next turn */
+    static void done(RD_INTERFACE*, void* context, int slot, int result)
+    {
+        Executor* executor = static_cast<Executor*>(context);
+        Slot finished = std::move(executor->slots_[slot]);
+        executor->slots_[slot] = Slot();
+        finished.done(result);
+    }
+    static void flush(void* context)
+    {
+        Executor* executor = static_cast<Executor*>(context);
+        RdAsyncWindowDrain(executor->rd_interface_, &executor->window_);
+    }
+
+    /* command of a coroutine in flight */
+    struct Slot
+    {
+        std::function<int(RD_INTERFACE*)> call;
+        std::function<void(int)> done;
+    };
+
+    RD_INTERFACE* rd_interface_;
+    RD_ASYNC_WINDOW window_;
+    Slot slots_[RD_MAX_PENDING + 1];
+    std::vector<Task> tasks_;
+    std::deque<std::coroutine_handle<> > ready_;
+};
+
+/* ================================================================== */
+template <class T> inline bool Command<T>::await_suspend(std::coroutine_handle<> waiter)
+{
+    waiter_ = waiter;
+    return executor_->send(this);
+}
+
+}
+
+#endif
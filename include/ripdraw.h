@@ -36,7 +36,7 @@ extern "C" {
 #define RDAPI extern
 #define RDAPI_INLINE static inline
 
-#define	RD_SLEEP(x)	sleep(x);
+#define	RD_SLEEP(x)	usleep((x) * 1000);
 #endif
 
 /* ================================================================== */
@@ -194,6 +194,148 @@ typedef struct _RD_INTERFACE_BUFFER
     RD_BYTE* ptr;
 } RD_INTERFACE_BUFFER;
 
+/* maximum payload of one frame, payload length is sent as uword */
+#define RD_MAX_PAYLOAD 0xFFFF
+/* largest frame: header, payload and checksum */
+#define RD_MAX_FRAME (RD_MAX_PAYLOAD + 8)
+/* build with RD_NO_HEAP defined and the command path never allocates:
+   request and response buffers of RD_MAX_FRAME bytes and room for RD_NO_HEAP_RESOURCES
+   registered resources are taken when the interface is opened, the journal is not available
+   and commands returning allocated data are left out, their View and Copy variants are not */
+#ifndef RD_NO_HEAP_RESOURCES
+#define RD_NO_HEAP_RESOURCES 256
+#endif
+/* maximum commands in flight when bulk writes are fragmented */
+#define RD_MAX_PENDING 16
+
+typedef struct _RD_INTERFACE_PENDING
+{
+    int cmd_id;
+    RD_UWORD seq_no;
+    /* time the request was written and its size, for link tuning */
+    long long sent_us;
+    int size;
+} RD_INTERFACE_PENDING;
+
+/* credits of requests in flight, see RdFlowSetBudget */
+typedef struct _RD_FLOW
+{
+    /* request bytes the device takes before replying, 0 without limit */
+    int budget;
+    /* budget is discovered: halved on an overrun, grown while replies arrive clean */
+    int discover;
+    /* requests sent and not answered */
+    int in_flight;
+    int in_flight_bytes;
+    /* bytes answered since the budget grew, replies answered since the last overrun */
+    int acked_bytes;
+    int clean;
+    /* waits for the oldest reply before sending, and their total time in microseconds */
+    long stalls;
+    long long stalled_us;
+    /* split commands refused with RD_FLOW_BLOCKED */
+    long blocked;
+    long overruns;
+} RD_FLOW;
+
+/* frames held for one write, see RdTxCoalesce */
+typedef struct _RD_TX
+{
+    /* longest time a frame is held in microseconds, 0 writes every frame at once */
+    int budget_us;
+    RD_INTERFACE_BUFFER buffer;
+    int frames;
+    /* time and sequence number of the first held frame */
+    long long first_us;
+    RD_UWORD first_seq;
+    /* writes to the port and frames they carried */
+    long writes;
+    long frames_written;
+} RD_TX;
+
+/* last known settings of a layer, see RdStateCacheEnable */
+#define RD_STATE_LAYERS 16
+#define RD_STATE_ENABLE 0x01
+#define RD_STATE_BACK_COLOR 0x02
+#define RD_STATE_TRANSPARENCY 0x04
+#define RD_STATE_ORIGIN_SIZE 0x08
+
+typedef struct _RD_LAYER_STATE
+{
+    /* RD_STATE_* bits of the values known */
+    int known;
+    RD_FLAG enable;
+    RD_COLOR back_color;
+    RD_BYTE transparency;
+    RD_POSITION position;
+    RD_SIZE size;
+} RD_LAYER_STATE;
+
+typedef struct _RD_STATE_CACHE
+{
+    RD_LAYER_STATE layers[RD_STATE_LAYERS];
+    int has_backlight;
+    RD_UWORD backlight;
+    /* set by RdStateCacheEnable(rd_interface, 0) */
+    int disabled;
+    /* commands not sent because their value was in effect */
+    long elided;
+} RD_STATE_CACHE;
+
+/* phase of a command split by RdAsyncPhase */
+typedef enum _RD_ASYNC_PHASE
+{
+    RD_ASYNC_NONE = 0, RD_ASYNC_SEND = 1, RD_ASYNC_COMPLETE = 2
+} RD_ASYNC_PHASE;
+
+/* kinds of resources the device hands out ids for */
+typedef enum _RD_RESOURCE_TYPE
+{
+    RD_RESOURCE_ALL = 0,
+    RD_RESOURCE_IMAGE,
+    RD_RESOURCE_IMAGE_WRITE,
+    RD_RESOURCE_IMAGE_LIST,
+    RD_RESOURCE_IMAGE_LIST_WRITE,
+    RD_RESOURCE_ANIMATION,
+    RD_RESOURCE_FONT,
+    RD_RESOURCE_STRING_WRITE,
+    RD_RESOURCE_CHARACTER_WRITE,
+    RD_RESOURCE_TEXT_WINDOW,
+    RD_RESOURCE_LINE_GRAPH,
+    RD_RESOURCE_BAR_GRAPH,
+    RD_RESOURCE_TOUCH,
+    RD_RESOURCE_TYPE_COUNT
+} RD_RESOURCE_TYPE;
+
+/* live device resource */
+typedef struct _RD_RESOURCE
+{
+    RD_RESOURCE_TYPE type;
+    /* id known by the client */
+    RD_ID id;
+    /* id used by the device, differs from id after a journal replay */
+    RD_ID device_id;
+    /* owner set by RdResourceSetOwner when the resource was created */
+    int owner;
+    /* number given at registration, client ids are reused but serials are not */
+    unsigned int serial;
+} RD_RESOURCE;
+
+/* resource id inside a journalled request */
+#define RD_JOURNAL_MAX_IDS 4
+
+typedef struct _RD_JOURNAL_ID
+{
+    /* offset in payload */
+    RD_UWORD offset;
+    RD_RESOURCE_TYPE type;
+    /* client id */
+    RD_ID id;
+} RD_JOURNAL_ID;
+
+/* longest warm start file name */
+#define RD_WARM_FILE_LENGTH 260
+
 typedef struct _RD_INTERFACE
 {
 	void* extint;
@@ -204,6 +346,52 @@ typedef struct _RD_INTERFACE
     RD_UWORD last_response_status;
     RD_INTERFACE_BUFFER request;
     RD_INTERFACE_BUFFER response;
+    /* sub-commands sent before waiting for the oldest reply, 0 or 1 waits for every reply */
+    int max_pending;
+    int pending_count;
+    RD_INTERFACE_PENDING pending[RD_MAX_PENDING];
+    /* live device resources in creation order */
+    RD_RESOURCE* resources;
+    int resource_count;
+    int resource_capacity;
+    int resource_owner;
+    /* serial of the newest registered resource */
+    unsigned int resource_serial;
+    /* device state journal, NULL unless enabled by RdJournalEnable */
+    struct _RD_JOURNAL* journal;
+    /* resource ids appended to the current request */
+    int request_id_count;
+    RD_JOURNAL_ID request_ids[RD_JOURNAL_MAX_IDS];
+    /* some device ids differ from client ids */
+    int remapped;
+    /* journal replay in progress */
+    int replaying;
+    /* touch id left on the device by RdWarmStartSave, gone after Rd_Reset */
+    RD_ID warm_sentinel;
+    int has_warm_sentinel;
+    /* file of the last RdWarmStartSave, removed when the sentinel goes */
+    char warm_file[RD_WARM_FILE_LENGTH];
+    /* newest serial saved in warm_file, those resources stay on the device on purpose */
+    unsigned int warm_serial;
+    /* set for interfaces created by RdBroadcastInit */
+    struct _RD_BROADCAST* broadcast;
+    /* split commands, see RdAsyncPhase */
+    RD_ASYNC_PHASE async_phase;
+    RD_INTERFACE_PENDING async_ticket;
+    /* completes split commands in flight before a direct command is sent, set by the event loop */
+    void (*async_flush)(void* context);
+    void* async_context;
+    /* last request written to the device */
+    RD_INTERFACE_PENDING sent;
+    /* link estimates, NULL unless enabled by RdTuneEnable */
+    struct _RD_TUNE* tune;
+    RD_FLOW flow;
+    RD_TX tx;
+    RD_STATE_CACHE state;
+    /* deferred commands, NULL before the first RdBatchBegin */
+    struct _RD_BATCH* batch;
+    /* images loaded ahead, NULL before the first RdPrefetchImage */
+    struct _RD_PREFETCH* prefetch;
 } RD_INTERFACE;
 
 typedef struct _RD_EVENT
@@ -247,7 +435,8 @@ RDAPI int Rd_LayerClear(RD_INTERFACE* rd_interface, RD_ID layer_id);
 /* Move Layer */
 RDAPI int Rd_LayerMove(RD_INTERFACE* rd_interface, RD_ID layer_id,
 RD_UWORD move_left, RD_UWORD move_top, RD_UWORD move_right, RD_UWORD move_bottom);
-/* Write Raw Pixels */
+/* Write Raw Pixels
+   Writes larger than one frame are split into several sub-commands */
 RDAPI int Rd_LayerWriteRawPixels(RD_INTERFACE* rd_interface, RD_ID layer_id,
 RD_POSITION position, RD_SIZE pixel_size, const RD_COLOR* pixels);
 /* Compose all Layers */
@@ -332,7 +521,8 @@ RDAPI int Rd_TextWindowDelete(RD_INTERFACE* rd_interface, RD_ID text_window_id);
 /*  Returns graph id of newly created graph */
 RDAPI int Rd_LineGraphCreateWindow(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_POSITION position,
 RD_SIZE size, RD_BYTE line_width, RD_BYTE line_glow_width, RD_FLAG autocompose, RD_ID* graph_id);
-/* set the line graph start point */
+/* set the line graph start point
+   Point lists larger than one frame are split into several sub-commands */
 RDAPI int Rd_LineGraphInsertPoints(RD_INTERFACE* rd_interface, RD_ID graph_id, RD_COLOR point_color,
 RD_UWORD point_length, const RD_POSITION* points);
 /* set line graph shift point */
@@ -367,16 +557,35 @@ RDAPI int Rd_TouchMapClear(RD_INTERFACE* rd_interface);
 /* ================================================================== */
 /* Information commands */
 /* Get Version */
+#ifndef RD_NO_HEAP
 RDAPI int Rd_SystemInfo(RD_INTERFACE* rd_interface, RD_GET_VERSION_TYPE type, char** output);
+#endif
+/* Get Version without allocation
+   data points into the response buffer and stays valid until the next command, it is not terminated */
+RDAPI int Rd_SystemInfoView(RD_INTERFACE* rd_interface, RD_GET_VERSION_TYPE type, const char** data, int* length);
+/* Get Version into buffer of the caller, terminated, fails when the buffer is too small */
+RDAPI int Rd_SystemInfoCopy(RD_INTERFACE* rd_interface, RD_GET_VERSION_TYPE type, char* buffer, int buffer_size,
+int* length);
 
 /* ================================================================== */
 /* Other commands */
 /* Reset all */
 RDAPI int Rd_Reset(RD_INTERFACE* rd_interface);
 /* Test Echo*/
+#ifndef RD_NO_HEAP
 RDAPI int Rd_TestEcho(RD_INTERFACE* rd_interface, const char* label, char** output);
+#endif
+/* Test Echo without allocation, data stays valid until the next command */
+RDAPI int Rd_TestEchoView(RD_INTERFACE* rd_interface, const char* label, const char** data, int* length);
+/* Test Echo into buffer of the caller, terminated */
+RDAPI int Rd_TestEchoCopy(RD_INTERFACE* rd_interface, const char* label, char* buffer, int buffer_size, int* length);
 /* Event Message */
+#ifndef RD_NO_HEAP
 RDAPI int Rd_EventMessage(RD_INTERFACE* rd_interface, RD_EVENT** event, RD_UWORD* count);
+#endif
+/* Event Message into array of the caller with room for capacity events
+   data of the events points into the response buffer and stays valid until the next command */
+RDAPI int Rd_EventMessageView(RD_INTERFACE* rd_interface, RD_EVENT* event, int capacity, RD_UWORD* count);
 
 /* ================================================================== */
 /* Flash commands */
@@ -385,7 +594,8 @@ RDAPI int Rd_FlashWriteEnable(RD_INTERFACE* rd_interface, RD_FLAG enable);
 /* Start file transfer
    Returns Transfer id */
 RDAPI int Rd_FlashImage(RD_INTERFACE* rd_interface, RD_UWORD type, const char* filename, RD_UWORD length, RD_ID* transfer_id);
-/* File transfer chunk */
+/* File transfer chunk
+   Chunks larger than one frame are split into several sub-commands */
 RDAPI int Rd_FlashData(RD_INTERFACE* rd_interface, RD_ID transfer_id, RD_UWORD type, const char* data);
 /* File delete */
 RDAPI int Rd_FlashDelete(RD_INTERFACE* rd_interface, RD_UWORD type, const char* filename);
@@ -401,6 +611,765 @@ RDAPI int Rd_GetBackLightBrightness(RD_INTERFACE* rd_interface, RD_UWORD* backli
 /* Set BackLight Brightness */
 RDAPI int Rd_SetBackLightBrightness(RD_INTERFACE* rd_interface, RD_UWORD backlight_brightness);
 
+/* ================================================================== */
+/* Host-side bitmap helpers */
+typedef struct _RD_BITMAP
+{
+    RD_SIZE size;
+    RD_COLOR* pixels;
+} RD_BITMAP;
+
+/* convert 32 bpp BGRA pixels (BMP byte order) to RD_COLOR order */
+RDAPI void RdPixelConvertBgra(RD_COLOR* dst, const RD_BYTE* src, int count);
+/* decode 32 bpp BMP image in memory, bottom-up rows are flipped
+   it is up to the user to free bitmap with RdBitmapFree */
+RDAPI int RdBitmapDecode(const RD_BYTE* data, int length, RD_BITMAP* bitmap);
+/* memory-map and decode 32 bpp BMP file */
+RDAPI int RdBitmapLoad(const char* file_name, RD_BITMAP* bitmap);
+/* free bitmap pixels */
+RDAPI int RdBitmapFree(RD_BITMAP* bitmap);
+/* load BMP file and write its pixels to layer */
+RDAPI int RdLayerWriteBitmapFile(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_POSITION position, const char* file_name);
+
+/* ================================================================== */
+/* Host shadow copy of raw pixel layers */
+typedef struct _RD_LAYER_SHADOW
+{
+    RD_ID layer_id;
+    RD_POSITION position;
+    RD_SIZE size;
+    RD_SIZE tile_size;
+    /* shadow matches the device, cleared when an upload failed */
+    int is_valid;
+    RD_COLOR* pixels;
+} RD_LAYER_SHADOW;
+
+/* create shadow for a rectangle of the layer fed with raw pixels
+   tile size of 0 uses 32x32 tiles, first update uploads whole rectangle */
+RDAPI int RdLayerShadowInit(RD_LAYER_SHADOW* shadow, RD_ID layer_id, RD_POSITION position, RD_SIZE size, RD_SIZE tile_size);
+/* free shadow pixels */
+RDAPI int RdLayerShadowFree(RD_LAYER_SHADOW* shadow);
+/* force next update to upload whole rectangle, e.g. after Rd_LayerClear */
+RDAPI void RdLayerShadowInvalidate(RD_LAYER_SHADOW* shadow);
+/* compare pixels with shadow tile by tile and write only changed tiles */
+RDAPI int RdLayerShadowUpdate(RD_INTERFACE* rd_interface, RD_LAYER_SHADOW* shadow, const RD_COLOR* pixels);
+
+/* ================================================================== */
+/* Packed asset file
+   header, RD_COLOR pixel blobs at RD_PACK_ALIGN offsets, index sorted by label at index_offset */
+#define RD_PACK_MAGIC "RDPK"
+#define RD_PACK_VERSION 1
+#define RD_PACK_ALIGN 64
+#define RD_PACK_LABEL_LENGTH 64
+
+typedef struct _RD_PACK_HEADER
+{
+    char magic[4];
+    unsigned int version;
+    unsigned int entry_count;
+    unsigned int index_offset;
+} RD_PACK_HEADER;
+
+typedef struct _RD_PACK_ENTRY
+{
+    char label[RD_PACK_LABEL_LENGTH];
+    RD_UWORD width;
+    RD_UWORD height;
+    /* position of the pixels inside the source image, not 0 when cropped */
+    RD_UWORD origin_x;
+    RD_UWORD origin_y;
+    unsigned int offset;
+    unsigned int length;
+    unsigned int hash;
+    unsigned int reserved;
+} RD_PACK_ENTRY;
+
+typedef struct _RD_PACK
+{
+    void* data;
+    unsigned int length;
+    int count;
+    const RD_PACK_ENTRY* entries;
+} RD_PACK;
+
+typedef struct _RD_PACK_WRITER
+{
+    FILE* file;
+    unsigned int offset;
+    int count;
+    int capacity;
+    RD_PACK_ENTRY* entries;
+} RD_PACK_WRITER;
+
+/* FNV-1a hash as stored in the pack index */
+RDAPI unsigned int RdPackHash(const RD_BYTE* data, int length);
+/* create pack file */
+RDAPI int RdPackWriterOpen(RD_PACK_WRITER* writer, const char* file_name);
+/* append bitmap pixels to pack */
+RDAPI int RdPackWriterAdd(RD_PACK_WRITER* writer, const char* label, const RD_BITMAP* bitmap, RD_POSITION origin);
+/* append bitmap pixels whose RdPackHash was already computed */
+RDAPI int RdPackWriterAddHashed(RD_PACK_WRITER* writer, const char* label, const RD_BITMAP* bitmap, RD_POSITION origin,
+unsigned int hash);
+/* write index and close pack file */
+RDAPI int RdPackWriterClose(RD_PACK_WRITER* writer);
+/* memory-map pack file */
+RDAPI int RdPackOpen(const char* file_name, RD_PACK* pack);
+/* unmap pack file, pixels returned by RdPackPixels become invalid */
+RDAPI int RdPackClose(RD_PACK* pack);
+/* find image by label, returns NULL if not found */
+RDAPI const RD_PACK_ENTRY* RdPackFind(const RD_PACK* pack, const char* label);
+/* pixels of image, points into the mapping */
+RDAPI const RD_COLOR* RdPackPixels(const RD_PACK* pack, const RD_PACK_ENTRY* entry);
+/* write image from pack to layer */
+RDAPI int RdLayerWritePackImage(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_POSITION position,
+const RD_PACK* pack, const char* label);
+
+/* ================================================================== */
+/* Line graph streaming
+   samples are buffered and decimated to the graph width (min/max per column) */
+typedef struct _RD_LINE_STREAM
+{
+    RD_ID graph_id;
+    RD_COLOR color;
+    RD_SIZE size;
+    /* value range mapped to graph height */
+    float min_value;
+    float max_value;
+    int samples_per_column;
+    int frame_interval_ms;
+    /* ring buffer of samples not sent yet */
+    float* samples;
+    int capacity;
+    int head;
+    int count;
+    /* samples dropped because ring buffer was full */
+    unsigned int dropped;
+    /* x of next column, wraps to 0 at graph width */
+    int column;
+    long long last_flush_us;
+    RD_POSITION* points;
+} RD_LINE_STREAM;
+
+/* create stream for a line graph window created with Rd_LineGraphCreateWindow */
+RDAPI int RdLineStreamInit(RD_LINE_STREAM* stream, RD_ID graph_id, RD_COLOR color, RD_SIZE size,
+float min_value, float max_value, int samples_per_column, int frame_interval_ms, int capacity);
+/* free stream buffers */
+RDAPI int RdLineStreamFree(RD_LINE_STREAM* stream);
+/* buffer one sample, oldest sample is dropped when buffer is full */
+RDAPI void RdLineStreamPush(RD_LINE_STREAM* stream, float value);
+/* buffer several samples */
+RDAPI void RdLineStreamPushArray(RD_LINE_STREAM* stream, const float* values, int count);
+/* send all complete columns with one Rd_LineGraphInsertPoints */
+RDAPI int RdLineStreamFlush(RD_INTERFACE* rd_interface, RD_LINE_STREAM* stream);
+/* flush when frame interval elapsed since last flush, call it from the main loop */
+RDAPI int RdLineStreamPoll(RD_INTERFACE* rd_interface, RD_LINE_STREAM* stream);
+
+/* ================================================================== */
+/* Bar graph with remembered stack count
+   only the difference to the shown stack count is sent */
+typedef struct _RD_BAR_GRAPH
+{
+    RD_ID graph_id;
+    /* image of inserted stacks */
+    RD_ID image_id;
+    /* stacks shown on device */
+    int stacks;
+    /* stacks requested by RdBarGraphSet, sent on flush */
+    int target;
+} RD_BAR_GRAPH;
+
+/* start tracking a bar graph window that currently shows given stacks */
+RDAPI int RdBarGraphInit(RD_BAR_GRAPH* bar, RD_ID graph_id, RD_ID image_id, int stacks);
+/* request stack count, several sets before a flush collapse into one command */
+RDAPI void RdBarGraphSet(RD_BAR_GRAPH* bar, int stacks);
+/* insert or remove the difference between requested and shown stacks */
+RDAPI int RdBarGraphFlush(RD_INTERFACE* rd_interface, RD_BAR_GRAPH* bar);
+/* set and flush */
+RDAPI int RdBarGraphSetNow(RD_INTERFACE* rd_interface, RD_BAR_GRAPH* bar, int stacks);
+
+/* ================================================================== */
+/* Readout: fixed width text written character by character
+   only changed characters are replaced, a readout changing more than threshold characters
+   several updates in a row becomes one string, it goes back after several small updates */
+#define RD_READOUT_MAX_LENGTH 32
+
+typedef struct _RD_READOUT
+{
+    RD_ID layer_id;
+    RD_POSITION position;
+    RD_ID font_id;
+    RD_COLOR color;
+    /* x distance between characters, font should be fixed width */
+    RD_UWORD advance;
+    int length;
+    /* changed characters above this count as a large update */
+    int threshold;
+    /* text shown, right aligned and padded with spaces */
+    char text[RD_READOUT_MAX_LENGTH + 1];
+    /* character writes on device */
+    int written;
+    RD_ID character_ids[RD_READOUT_MAX_LENGTH];
+    /* shown as one string instead of characters */
+    int string_mode;
+    RD_ID string_id;
+    /* consecutive updates within threshold while in string mode */
+    int small_updates;
+    /* consecutive updates above threshold while in character mode */
+    int large_updates;
+} RD_READOUT;
+
+/* write initial text of a readout with length characters */
+RDAPI int RdReadoutCreate(RD_INTERFACE* rd_interface, RD_READOUT* readout, RD_ID layer_id, RD_POSITION position,
+RD_ID font_id, RD_COLOR color, RD_UWORD advance, int length, int threshold, const char* text);
+/* show new text, sends only the changed characters */
+RDAPI int RdReadoutUpdate(RD_INTERFACE* rd_interface, RD_READOUT* readout, const char* text);
+/* delete readout from layer */
+RDAPI int RdReadoutDelete(RD_INTERFACE* rd_interface, RD_READOUT* readout);
+
+/* ================================================================== */
+/* Console: grid of character cells on a layer
+   text is written to host cells, a flush sends only the changed cells */
+typedef struct _RD_CONSOLE
+{
+    RD_ID layer_id;
+    RD_POSITION position;
+    RD_ID font_id;
+    int font_loaded;
+    RD_COLOR color;
+    /* pixel size of one cell, font should be fixed width */
+    RD_SIZE cell_size;
+    int rows;
+    int columns;
+    int cursor_row;
+    int cursor_column;
+    /* text of cells, rows * columns */
+    char* cells;
+    /* text shown on device, space means no character */
+    char* shown;
+    /* character write id of shown cells */
+    RD_ID* ids;
+    /* rows changed since last flush */
+    RD_BYTE* damaged;
+} RD_CONSOLE;
+
+/* load font and create empty console of rows x columns cells */
+RDAPI int RdConsoleCreate(RD_INTERFACE* rd_interface, RD_CONSOLE* console, RD_ID layer_id, RD_POSITION position,
+const char* font_label, RD_COLOR color, RD_SIZE cell_size, int rows, int columns);
+/* delete shown characters, release font and free console */
+RDAPI int RdConsoleDelete(RD_INTERFACE* rd_interface, RD_CONSOLE* console);
+/* write text at cursor, handles new line and scrolls at the last row */
+RDAPI void RdConsoleWrite(RD_CONSOLE* console, const char* text);
+/* clear all cells and move cursor home */
+RDAPI void RdConsoleClear(RD_CONSOLE* console);
+/* move cursor */
+RDAPI void RdConsoleSetCursor(RD_CONSOLE* console, int row, int column);
+/* send changed cells, call once per frame */
+RDAPI int RdConsoleFlush(RD_INTERFACE* rd_interface, RD_CONSOLE* console);
+
+/* ================================================================== */
+/* Log sink: lines from any thread appended to a text window
+   at most max_bytes are sent per frame interval, further lines are dropped and counted */
+typedef struct _RD_LOG_SINK
+{
+    RD_ID text_window_id;
+    int frame_interval_ms;
+    int max_bytes;
+    /* lines collected since last flush */
+    char* buffer;
+    int size;
+    /* buffer of the last flush */
+    char* sending;
+    /* lines dropped since last flush, reported in the next flush */
+    unsigned int dropped;
+    unsigned int total_dropped;
+    long long last_flush_us;
+    void* lock;
+} RD_LOG_SINK;
+
+/* create log sink for a text window created by Rd_TextWindowCreate */
+RDAPI int RdLogSinkInit(RD_LOG_SINK* sink, RD_ID text_window_id, int frame_interval_ms, int max_bytes);
+/* free log sink */
+RDAPI int RdLogSinkFree(RD_LOG_SINK* sink);
+/* add a line, may be called from any thread, nothing is sent */
+RDAPI void RdLogSinkWrite(RD_LOG_SINK* sink, const char* line);
+/* send collected lines with one Rd_TextWindowInsertText */
+RDAPI int RdLogSinkFlush(RD_INTERFACE* rd_interface, RD_LOG_SINK* sink);
+/* flush when the frame interval has elapsed, call from the thread that owns the interface */
+RDAPI int RdLogSinkPoll(RD_INTERFACE* rd_interface, RD_LOG_SINK* sink);
+
+/* ================================================================== */
+/* Touch registry: touch map regions with label and handler
+   indexed by a uniform grid for lookups by position and by touch id */
+#define RD_TOUCH_LABEL_LENGTH 32
+
+struct _RD_TOUCH_REGION;
+typedef void (*RD_TOUCH_HANDLER)(const struct _RD_TOUCH_REGION* region, void* context);
+
+typedef struct _RD_TOUCH_REGION
+{
+    /* set when registered */
+    RD_ID touch_id;
+    /* top left of rectangle or center of circle */
+    RD_POSITION position;
+    /* size of rectangle */
+    RD_SIZE size;
+    /* radius of circle, 0 for rectangles */
+    RD_UWORD outer_radius;
+    RD_UWORD inner_radius;
+    char label[RD_TOUCH_LABEL_LENGTH];
+    RD_TOUCH_HANDLER handler;
+    void* context;
+} RD_TOUCH_REGION;
+
+typedef struct _RD_TOUCH_REGISTRY
+{
+    RD_SIZE screen_size;
+    RD_SIZE cell_size;
+    int grid_columns;
+    int grid_rows;
+    /* regions in registration order */
+    RD_TOUCH_REGION* regions;
+    int count;
+    int capacity;
+    /* regions of grid cell i are cell_regions[cell_start[i]] to cell_regions[cell_start[i + 1] - 1] */
+    int* cell_start;
+    int* cell_regions;
+    /* pairs of touch id and region index, sorted by touch id */
+    int* by_id;
+    /* index is rebuilt on the first lookup after a change */
+    int is_indexed;
+} RD_TOUCH_REGISTRY;
+
+/* create empty registry, cell size 0 uses the default of 32 pixels */
+RDAPI int RdTouchRegistryInit(RD_TOUCH_REGISTRY* registry, RD_SIZE screen_size, RD_SIZE cell_size);
+/* free registry */
+RDAPI int RdTouchRegistryFree(RD_TOUCH_REGISTRY* registry);
+/* map region on device and register it, touch_id of region is set */
+RDAPI int RdTouchRegistryAdd(RD_INTERFACE* rd_interface, RD_TOUCH_REGISTRY* registry, RD_TOUCH_REGION* region);
+/* map and register count regions, index is built once on the next lookup */
+RDAPI int RdTouchRegistryAddArray(RD_INTERFACE* rd_interface, RD_TOUCH_REGISTRY* registry, RD_TOUCH_REGION* regions, int count);
+/* delete region from device and registry */
+RDAPI int RdTouchRegistryRemove(RD_INTERFACE* rd_interface, RD_TOUCH_REGISTRY* registry, RD_ID touch_id);
+/* clear touch map of device and registry, e.g. before registering a new scene */
+RDAPI int RdTouchRegistryClear(RD_INTERFACE* rd_interface, RD_TOUCH_REGISTRY* registry);
+/* topmost region containing position or NULL */
+RDAPI const RD_TOUCH_REGION* RdTouchRegistryFind(RD_TOUCH_REGISTRY* registry, RD_POSITION position);
+/* region of touch id or NULL */
+RDAPI const RD_TOUCH_REGION* RdTouchRegistryFindId(RD_TOUCH_REGISTRY* registry, RD_ID touch_id);
+/* call handler of touch id, returns 1 if a handler was called */
+RDAPI int RdTouchRegistryDispatch(RD_TOUCH_REGISTRY* registry, RD_ID touch_id);
+
+/* ================================================================== */
+/* Display group: several panels driven in parallel
+   every panel has a worker thread that runs the jobs submitted for it */
+#define RD_GROUP_MAX_PANELS 16
+
+/* job run by the worker of a panel, returns negative value on error */
+typedef int (*RD_PANEL_JOB)(RD_INTERFACE* rd_interface, int panel, void* context);
+
+typedef struct _RD_PANEL
+{
+    RD_INTERFACE* rd_interface;
+    int index;
+    struct _RD_DISPLAY_GROUP* group;
+    /* job submitted and not finished yet */
+    RD_PANEL_JOB job;
+    void* context;
+    /* result of last finished job */
+    int result;
+} RD_PANEL;
+
+typedef struct _RD_DISPLAY_GROUP
+{
+    int count;
+    RD_PANEL panels[RD_GROUP_MAX_PANELS];
+    /* panels with a job not finished yet */
+    int running;
+    /* jobs failed since the group was opened */
+    int failed;
+    void* sync;
+} RD_DISPLAY_GROUP;
+
+/* open count ports and start a worker for each panel */
+RDAPI int RdDisplayGroupOpen(RD_DISPLAY_GROUP* group, const char** port_names, int count);
+/* finish submitted jobs, stop workers and close all interfaces */
+RDAPI int RdDisplayGroupClose(RD_DISPLAY_GROUP* group);
+/* start job on one panel, waits while the panel still runs a previous job */
+RDAPI int RdDisplayGroupSubmit(RD_DISPLAY_GROUP* group, int panel, RD_PANEL_JOB job, void* context);
+/* run job on all panels concurrently and wait for all of them */
+RDAPI int RdDisplayGroupRun(RD_DISPLAY_GROUP* group, RD_PANEL_JOB job, void* context);
+/* wait for all submitted jobs, returns error of the first failed panel */
+RDAPI int RdDisplayGroupWait(RD_DISPLAY_GROUP* group);
+
+/* ================================================================== */
+/* Broadcast: interface writing every command to several mirrored displays
+   a frame is encoded once, only sequence number and checksum are patched per member */
+#define RD_BROADCAST_MAX_MEMBERS 16
+/* sequence numbers remembered per member, larger than commands in flight */
+#define RD_BROADCAST_SEQ_RING 32
+
+typedef struct _RD_BROADCAST_MEMBER
+{
+    RD_INTERFACE* rd_interface;
+    /* member sequence number of broadcast sequence number modulo ring size */
+    RD_UWORD seq_map[RD_BROADCAST_SEQ_RING];
+    /* frame written and response not received yet */
+    RD_BYTE sent[RD_BROADCAST_SEQ_RING];
+    /* result of last write or response */
+    int result;
+    /* failed writes and responses */
+    unsigned int failed;
+} RD_BROADCAST_MEMBER;
+
+typedef struct _RD_BROADCAST
+{
+    int count;
+    RD_BROADCAST_MEMBER members[RD_BROADCAST_MAX_MEMBERS];
+} RD_BROADCAST;
+
+/* create interface sending every command to all members
+   responses of all members are checked, ids and data are taken from the first member that replied
+   returns interface pointer on success OR NULL on failed, close it with RdInterfaceClose
+   members stay open and are closed by the caller */
+RDAPI RD_INTERFACE* RdBroadcastInit(RD_INTERFACE** members, int count);
+
+/* ================================================================== */
+/* Resource registry
+   every id returned by the device is registered with its type and owner,
+   releasing or deleting it unregisters it, RdInterfaceClose reports resources never released
+   except those kept for a warm start by RdWarmStartSave */
+/* owner of resources created from now on, returns previous owner */
+RDAPI int RdResourceSetOwner(RD_INTERFACE* rd_interface, int owner);
+/* number of live resources of owner, owner -1 counts all */
+RDAPI int RdResourceCount(RD_INTERFACE* rd_interface, int owner);
+/* release or delete all resources of owner, newest first, owner -1 releases all
+   commands are sent without waiting for each reply when max_pending allows
+   on error every reply is still read, resources the device released are unregistered
+   and those whose release failed or was not sent stay registered */
+RDAPI int RdResourceReleaseOwner(RD_INTERFACE* rd_interface, int owner);
+/* 1 when the resource is still live, 0 after it was released or the device was reset */
+RDAPI int RdResourceIsLive(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+/* serial of a live resource, 0 when it is not live
+   an id reused after a release or Rd_Reset gets a new serial */
+RDAPI unsigned int RdResourceSerial(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+/* print live resources */
+RDAPI void RdResourceReport(RD_INTERFACE* rd_interface, FILE* file);
+
+/* ================================================================== */
+/* Journal: compact record of the live device state
+   commands creating resources, the last update of each kind per resource (Rd_ImageMove,
+   Rd_ImageListReplace, Rd_StringReplace, Rd_CharacterReplace, Rd_SetFontPadding),
+   layer settings, the backlight and the last compose of each page are kept in command order,
+   released resources drop out with their updates, a reconnect replays the rest after Rd_Reset.
+   Content drawn incrementally is not journalled: Rd_LayerWriteRawPixels, Rd_LayerMove, Rd_LayerClear,
+   Rd_TextWindowInsertText, Rd_LineGraphInsertPoints, Rd_LineGraphMove, Rd_BarGraphInsertStacks and
+   Rd_BarGraphRemoveStacks must be sent again by the application after a replay */
+typedef struct _RD_JOURNAL_ENTRY
+{
+    int cmd_id;
+    /* type of the created or updated resource, RD_RESOURCE_ALL for layer, page and device settings */
+    RD_RESOURCE_TYPE type;
+    /* client id of the resource, layer or page id of settings */
+    RD_ID id;
+    /* 1 when the entry changes a live resource or setting instead of creating a resource */
+    int update;
+    /* resource ids in payload, translated to device ids on replay */
+    int id_count;
+    RD_JOURNAL_ID ids[RD_JOURNAL_MAX_IDS];
+    int length;
+    RD_BYTE* payload;
+} RD_JOURNAL_ENTRY;
+
+typedef struct _RD_JOURNAL
+{
+    /* entries in command order */
+    RD_JOURNAL_ENTRY* entries;
+    int count;
+    int capacity;
+} RD_JOURNAL;
+
+/* start or stop journalling device state, stopping frees the journal */
+RDAPI int RdJournalEnable(RD_INTERFACE* rd_interface, int enable);
+/* reset device and replay journal, client ids of resources stay valid */
+RDAPI int RdJournalReplay(RD_INTERFACE* rd_interface);
+/* reopen the port after the link dropped or the device rebooted and replay journal */
+RDAPI int RdInterfaceReconnect(RD_INTERFACE* rd_interface, const char* port_name);
+
+/* ================================================================== */
+/* Warm start: reattach to the screen left by a previous run
+   RdWarmStartSave stores the device identity, a scene fingerprint chosen by the application,
+   the resource registry and the journal, and leaves a sentinel touch region on the device.
+   RdWarmStartAttach checks identity and fingerprint and deletes the sentinel as state probe,
+   a reset or power cycle of the device removed it. The file is removed when it can not be
+   attached to and before Rd_Reset or Rd_TouchMapClear remove the sentinel, so a touch region
+   created later with the sentinel id does not pass the probe. The sentinel label is new on every
+   save and tells its touch events apart, the protocol has no command reading a label back. */
+#define RD_WARM_MAGIC "RDWS"
+#define RD_WARM_VERSION 4
+
+/* returns 1 and restores registry and journal when the device still shows the saved scene,
+   0 when the scene has to be built, it is saved again with RdWarmStartSave after building,
+   a reattached scene is saved again by RdWarmStartAttach */
+RDAPI int RdWarmStartAttach(RD_INTERFACE* rd_interface, const char* file_name, unsigned int fingerprint);
+/* save state of the scene just built */
+RDAPI int RdWarmStartSave(RD_INTERFACE* rd_interface, const char* file_name, unsigned int fingerprint);
+/* FNV-1a over data continuing from fingerprint, start with RD_WARM_FINGERPRINT_START
+   feed the values describing the scene, such as names and positions, never pointers */
+#define RD_WARM_FINGERPRINT_START 2166136261u
+RDAPI unsigned int RdWarmFingerprint(unsigned int fingerprint, const void* data, int length);
+
+/* ================================================================== */
+/* Split commands for event loops
+   in RD_ASYNC_SEND an Rd_* command only sends its request and returns RD_ASYNC_SENT,
+   async_ticket of the interface then identifies its reply. Replies arrive in send order,
+   RdAsyncReceive waits for the reply of a ticket. The command is then called once more with
+   the same arguments in RD_ASYNC_COMPLETE: it is encoded again but not sent, and handles the
+   received reply like a direct call, e.g. returns and registers the new id.
+   Only commands sending a single frame can be split, not bulk writes.
+   Direct commands in between call async_flush first, the event loop completes what is in flight. */
+#define RD_ASYNC_SENT (-010000)
+
+/* set phase of following commands, ticket is the reply to complete in RD_ASYNC_COMPLETE */
+RDAPI void RdAsyncPhase(RD_INTERFACE* rd_interface, RD_ASYNC_PHASE phase, const RD_INTERFACE_PENDING* ticket);
+/* wait for reply of a sent command, fails when the device reports an error */
+RDAPI int RdAsyncReceive(RD_INTERFACE* rd_interface, const RD_INTERFACE_PENDING* ticket);
+
+/* Window of split commands: up to size commands in flight, completed oldest first
+   command sends or completes the command of an item in the current phase, done gets the
+   result of every command sent. A request refused with RD_FLOW_BLOCKED is sent again once
+   the oldest command completed. Inside a split command, a broadcast or a batch the window is
+   direct: commands are called at once, a split request would pass the commands queued. */
+typedef int (*RD_ASYNC_COMMAND)(RD_INTERFACE* rd_interface, void* context, int item);
+typedef void (*RD_ASYNC_DONE)(RD_INTERFACE* rd_interface, void* context, int item, int result);
+
+typedef struct _RD_ASYNC_WINDOW
+{
+    RD_ASYNC_COMMAND command;
+    RD_ASYNC_DONE done;
+    void* context;
+    /* commands in flight at most, max_pending by default, may be lowered after init */
+    int size;
+    int direct;
+    int first;
+    int count;
+    int items[RD_MAX_PENDING];
+    RD_INTERFACE_PENDING tickets[RD_MAX_PENDING];
+} RD_ASYNC_WINDOW;
+
+/* empty window, split commands in flight elsewhere are completed first by async_flush */
+RDAPI void RdAsyncWindowInit(RD_INTERFACE* rd_interface, RD_ASYNC_WINDOW* window, RD_ASYNC_COMMAND command,
+RD_ASYNC_DONE done, void* context);
+/* send command of item without waiting, RD_FLOW_BLOCKED when the window or the flow budget is full
+   returns 0 when it was sent or called directly, else its error and done is not called */
+RDAPI int RdAsyncWindowTrySend(RD_INTERFACE* rd_interface, RD_ASYNC_WINDOW* window, int item);
+/* send command of item, the oldest commands are completed until it fits */
+RDAPI int RdAsyncWindowSend(RD_INTERFACE* rd_interface, RD_ASYNC_WINDOW* window, int item);
+/* wait for the reply of the oldest command and complete it, returns its result */
+RDAPI int RdAsyncWindowComplete(RD_INTERFACE* rd_interface, RD_ASYNC_WINDOW* window);
+/* complete every command in flight, returns the first error */
+RDAPI int RdAsyncWindowDrain(RD_INTERFACE* rd_interface, RD_ASYNC_WINDOW* window);
+
+/* ================================================================== */
+/* Link tuning: wire and device time estimated from the replies
+   a reply is timed from sending its request, or from the previous reply when it was sent
+   before that one arrived. Round trips of one command id with different request and reply
+   lengths give the time per byte, the rest of a round trip is the service time of the command.
+   Pipelined replies give the gap between replies the link or the device sustains.
+   max_pending is set after each reply to round trip / gap, limited so that a command
+   queues no longer than the latency budget behind the commands in flight before it. */
+#define RD_TUNE_SLOTS 32
+/* 115200 baud 8N1, until commands of different lengths were seen */
+#define RD_TUNE_US_PER_BYTE 87.0
+
+typedef struct _RD_TUNE_COMMAND
+{
+    int cmd_id;
+    /* decayed weight of round trips, means of bytes and time in microseconds */
+    double weight;
+    double mean_bytes;
+    double mean_us;
+    /* decayed co-moments of bytes and time */
+    double sxx;
+    double sxy;
+    /* decayed gap to the previous reply when pipelined, 0 before the first one */
+    double gap_us;
+} RD_TUNE_COMMAND;
+
+typedef struct _RD_TUNE
+{
+    RD_TUNE_COMMAND commands[RD_TUNE_SLOTS];
+    /* wire time of one byte, microseconds */
+    double us_per_byte;
+    /* longest queueing in front of a command, microseconds */
+    long long latency_us;
+    /* arrival of the previous reply */
+    long long last_reply_us;
+    /* window chosen after the last reply */
+    int window;
+    long long samples;
+} RD_TUNE;
+
+/* start tuning max_pending with the given latency budget, 0 stops and frees the estimates */
+RDAPI int RdTuneEnable(RD_INTERFACE* rd_interface, int latency_budget_us);
+/* estimated device service time of a command in microseconds, -1 before its first reply */
+RDAPI double RdTuneServiceUs(RD_INTERFACE* rd_interface, int cmd_id);
+/* print link and command estimates */
+RDAPI void RdTuneReport(RD_INTERFACE* rd_interface, FILE* file);
+
+/* ================================================================== */
+/* Flow control: requests in flight hold credits of their bytes until their reply arrived
+   a request not fitting the budget of the device receive buffer waits for the oldest replies,
+   a split command returns RD_FLOW_BLOCKED instead, its event loop completes a command
+   and sends it again. A request is always sent when nothing is in flight, and a direct
+   command is sent over the budget when only split commands are in flight.
+   With RD_FLOW_AUTO the budget starts at RD_FLOW_AUTO_START, a sequence or checksum error
+   while several requests were in flight halves it, every budget of clean replies adds
+   RD_FLOW_AUTO_STEP up to RD_FLOW_AUTO_MAX. */
+#define RD_FLOW_BLOCKED (-010001)
+#define RD_FLOW_AUTO (-1)
+#define RD_FLOW_AUTO_START 4096
+#define RD_FLOW_AUTO_MIN 256
+#define RD_FLOW_AUTO_STEP 256
+#define RD_FLOW_AUTO_MAX 65536
+
+/* set budget in bytes, RD_FLOW_AUTO discovers it, 0 sends without limit */
+RDAPI int RdFlowSetBudget(RD_INTERFACE* rd_interface, int budget);
+/* print budget and stall metrics */
+RDAPI void RdFlowReport(RD_INTERFACE* rd_interface, FILE* file);
+
+/* ================================================================== */
+/* Write coalescing: small frames are held and written together
+   a frame is held until the budget of the first held frame ran out, RD_TX_CAPACITY bytes are
+   held or its own reply is awaited. Waiting for the reply of an earlier frame keeps it held,
+   so pipelined and split commands sent meanwhile share the next write. A direct command
+   waits for its reply at once and is written alone. */
+#define RD_TX_CAPACITY 1024
+
+/* hold frames at most budget_us, 0 writes each frame at once, returns previous budget
+   e.g. an urgent command is sent with budget 0 and the previous budget is set again after it */
+RDAPI int RdTxCoalesce(RD_INTERFACE* rd_interface, int budget_us);
+/* write held frames */
+RDAPI int RdTxFlush(RD_INTERFACE* rd_interface);
+
+/* ================================================================== */
+/* State cache: last known layer settings and backlight brightness of the device
+   a setter repeating the value in effect returns 0 without sending, e.g. code enabling
+   the layer of every image it writes sends Rd_SetLayerEnable once per layer.
+   A value is known once the device accepted it and is forgotten while it is sent again,
+   Rd_LayerMove forgets origin and size, Rd_Reset and RdInterfaceReconnect forget all.
+   Broadcast interfaces keep no cache, a broadcast command forgets the cache of the members. */
+/* cache is on by default, disabling forgets it */
+RDAPI int RdStateCacheEnable(RD_INTERFACE* rd_interface, int enable);
+/* forget all values, e.g. after the device was reset by other means */
+RDAPI void RdStateCacheForget(RD_INTERFACE* rd_interface);
+
+/* ================================================================== */
+/* Batch: commands without reply data are queued and optimised before they are sent
+   queued commands return 0, the first error of the device is returned when the batch is sent.
+   Loads and information requests are sent at once, ahead of the queue, unless a release or
+   delete is queued, any other command returning an id or data sends the queue first.
+   Before sending, repeated absolute updates of the same layer or write (e.g. Rd_ImageMove,
+   Rd_SetLayerBackColor) keep only the last one unless a command other than such an update
+   is for the same layer or write in between (e.g. Rd_LayerMove), updates of a write deleted
+   later are dropped and composes of the same page are merged.
+   Nothing is moved across a compose that is kept, Rd_PageToScreen,
+   Rd_PartialComposeLayersToScreen or Rd_LayerClear, so every page shown is the same.
+   Relative updates like Rd_LayerMove are sent as they are. */
+typedef struct _RD_BATCH_ENTRY
+{
+    int cmd_id;
+    /* frame in the frames buffer */
+    int offset;
+    int length;
+    int dropped;
+} RD_BATCH_ENTRY;
+
+typedef struct _RD_BATCH
+{
+    int active;
+    /* last request was queued, there is no reply to wait for */
+    int queued;
+    RD_BATCH_ENTRY* entries;
+    int count;
+    int capacity;
+    RD_INTERFACE_BUFFER frames;
+    /* commands queued and frames sent after optimising */
+    long commands;
+    long sent;
+} RD_BATCH;
+
+/* queue commands from now on */
+RDAPI int RdBatchBegin(RD_INTERFACE* rd_interface);
+/* optimise and send queued commands, the batch stays open */
+RDAPI int RdBatchSubmit(RD_INTERFACE* rd_interface);
+/* send queued commands and stop queueing */
+RDAPI int RdBatchEnd(RD_INTERFACE* rd_interface);
+#ifdef RD_BATCH_CHECK
+/* check the optimiser on fixed command sequences, returns 0 or the number of the failing sequence */
+RDAPI int RdBatchCheck(void);
+#endif
+
+/* ================================================================== */
+/* Prefetch: images of upcoming screens loaded while the link is idle
+   the images and image lists the next screens use are declared while one is shown,
+   RdPrefetchPoll sends their loads as split commands when nothing else is in flight
+   and no batch is active.
+   Their replies are taken before the next command is sent, the ids are kept by label.
+   RdPrefetchImageId returns the id of a label, loading it directly when it was not
+   prefetched or its image was released or reset since. Not available with RD_NO_HEAP,
+   the table of labels grows with the declared loads. */
+#define RD_PREFETCH_LABEL_LENGTH 64
+
+typedef enum _RD_PREFETCH_STATE
+{
+    RD_PREFETCH_DECLARED = 0, RD_PREFETCH_SENT, RD_PREFETCH_READY, RD_PREFETCH_FAILED
+} RD_PREFETCH_STATE;
+
+typedef struct _RD_PREFETCH_ENTRY
+{
+    /* RD_RESOURCE_IMAGE or RD_RESOURCE_IMAGE_LIST */
+    RD_RESOURCE_TYPE type;
+    /* label of an image, prefix of an image list */
+    char label[RD_PREFETCH_LABEL_LENGTH];
+    RD_UWORD index_start;
+    RD_UWORD index_step;
+    RD_UWORD index_count;
+    RD_PREFETCH_STATE state;
+    RD_ID id;
+    int error;
+} RD_PREFETCH_ENTRY;
+
+typedef struct _RD_PREFETCH
+{
+    RD_PREFETCH_ENTRY* entries;
+    int count;
+    int capacity;
+    /* loads in flight, items are entry indices */
+    RD_ASYNC_WINDOW window;
+    /* loads of the prefetch itself are sent or completed */
+    int busy;
+    /* loads prefetched, ids found ready and ids loaded on demand */
+    long loaded;
+    long hits;
+    long misses;
+} RD_PREFETCH;
+
+/* declare an image to load ahead */
+RDAPI int RdPrefetchImage(RD_INTERFACE* rd_interface, const char* image_label);
+/* declare an image list to load ahead */
+RDAPI int RdPrefetchImageList(RD_INTERFACE* rd_interface, const char* prefix, RD_UWORD index_start,
+RD_UWORD index_step, RD_UWORD index_count);
+/* send declared loads when the link is idle, call it from the main loop
+   at most max_pending loads (at least one) are sent per call, so the next command waits
+   for a few replies only */
+RDAPI int RdPrefetchPoll(RD_INTERFACE* rd_interface);
+/* id of an image, loaded now when it is not ready */
+RDAPI int RdPrefetchImageId(RD_INTERFACE* rd_interface, const char* image_label, RD_ID* image_id);
+/* id of an image list, loaded now when it is not ready */
+RDAPI int RdPrefetchImageListId(RD_INTERFACE* rd_interface, const char* prefix, RD_UWORD index_start,
+RD_UWORD index_step, RD_UWORD index_count, RD_ID* image_list_id);
+RDAPI void RdPrefetchReport(RD_INTERFACE* rd_interface, FILE* file);
+
 /* ================================================================== */
 /* helper macros */
 #define _RD_CHECK_INTERFACE()\
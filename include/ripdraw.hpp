@@ -0,0 +1,403 @@
+/* ripdraw.hpp
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * header only C++11 layer over ripdraw.h
+ * an Interface closes its port, resource handles release their device resource,
+ * commands return a Result holding the value or the negative error code
+ */
+#ifndef _RIPDRAW_HPP_
+#define _RIPDRAW_HPP_
+
+#include <string>
+#include <utility>
+#include "ripdraw.h"
+
+namespace ripdraw
+{
+
+/* ================================================================== */
+/* value of a command or its error code */
+template <class T> class Result
+{
+public:
+    Result(T&& value) : value_(std::move(value)), error_(0) {}
+    Result(const T& value) : value_(value), error_(0) {}
+    static Result failure(int error)
+    {
+        return Result(error, 0);
+    }
+
+    bool ok() const { return error_ == 0; }
+    explicit operator bool() const { return error_ == 0; }
+    /* negative error code of the C API, 0 on success */
+    int error() const { return error_; }
+    T& value() { return value_; }
+    const T& value() const { return value_; }
+    T* operator->() { return &value_; }
+    const T* operator->() const { return &value_; }
+    T& operator*() { return value_; }
+    const T& operator*() const { return value_; }
+
+private:
+    Result(int error, int) : value_(), error_(error) {}
+    T value_;
+    int error_;
+};
+
+/* result of a command without value */
+template <> class Result<void>
+{
+public:
+    Result(int ret = 0) : error_(ret < 0 ? ret : 0) {}
+    static Result failure(int error)
+    {
+        return Result(error);
+    }
+
+    bool ok() const { return error_ == 0; }
+    explicit operator bool() const { return error_ == 0; }
+    int error() const { return error_; }
+
+private:
+    int error_;
+};
+
+/* ================================================================== */
+/* command releasing a resource type */
+template <RD_RESOURCE_TYPE Type> struct ResourceTraits;
+
+#define _RD_HPP_RESOURCE(type, function)\
+    template <> struct ResourceTraits<type>\
+    {\
+        static int release(RD_INTERFACE* rd_interface, RD_ID id) { return function(rd_interface, id); }\
+    };
+
+_RD_HPP_RESOURCE(RD_RESOURCE_IMAGE, Rd_ImageRelease)
+_RD_HPP_RESOURCE(RD_RESOURCE_IMAGE_WRITE, Rd_ImageDelete)
+_RD_HPP_RESOURCE(RD_RESOURCE_IMAGE_LIST, Rd_ImageListRelease)
+_RD_HPP_RESOURCE(RD_RESOURCE_IMAGE_LIST_WRITE, Rd_ImageListDelete)
+_RD_HPP_RESOURCE(RD_RESOURCE_ANIMATION, Rd_AnimationDelete)
+_RD_HPP_RESOURCE(RD_RESOURCE_FONT, Rd_FontRelease)
+_RD_HPP_RESOURCE(RD_RESOURCE_STRING_WRITE, Rd_StringDelete)
+_RD_HPP_RESOURCE(RD_RESOURCE_CHARACTER_WRITE, Rd_CharacterDelete)
+_RD_HPP_RESOURCE(RD_RESOURCE_TEXT_WINDOW, Rd_TextWindowDelete)
+_RD_HPP_RESOURCE(RD_RESOURCE_LINE_GRAPH, Rd_LineGraphDeleteWindow)
+_RD_HPP_RESOURCE(RD_RESOURCE_BAR_GRAPH, Rd_BarGraphDeleteWindow)
+_RD_HPP_RESOURCE(RD_RESOURCE_TOUCH, Rd_TouchMapDelete)
+
+#undef _RD_HPP_RESOURCE
+
+/* ================================================================== */
+/* owner of one device resource, released when the handle goes away
+   resources already gone after Rd_Reset or Rd_TouchMapClear are not released again,
+   the handle keeps the serial of its resource, a new resource reusing the id is left alone,
+   handles must not outlive the Interface that created them */
+template <RD_RESOURCE_TYPE Type> class Handle
+{
+public:
+    Handle() : rd_interface_(NULL), id_(0), serial_(0) {}
+    Handle(RD_INTERFACE* rd_interface, RD_ID id)
+        : rd_interface_(rd_interface), id_(id), serial_(RdResourceSerial(rd_interface, Type, id)) {}
+    ~Handle() { reset(); }
+
+    Handle(Handle&& other) : rd_interface_(other.rd_interface_), id_(other.id_), serial_(other.serial_)
+    {
+        other.rd_interface_ = NULL;
+    }
+    Handle& operator=(Handle&& other)
+    {
+        if (this != &other)
+        {
+            reset();
+            rd_interface_ = other.rd_interface_;
+            id_ = other.id_;
+            serial_ = other.serial_;
+            other.rd_interface_ = NULL;
+        }
+        return *this;
+    }
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+
+    RD_ID id() const { return id_; }
+    explicit operator bool() const { return rd_interface_ != NULL; }
+
+    /* give up ownership, the resource stays on the device */
+    RD_ID detach()
+    {
+        rd_interface_ = NULL;
+        return id_;
+    }
+    /* release now, returns the result of the release command */
+    Result<void> reset()
+    {
+        RD_INTERFACE* rd_interface = rd_interface_;
+        rd_interface_ = NULL;
+        if (rd_interface == NULL || serial_ == 0 || RdResourceSerial(rd_interface, Type, id_) != serial_)
+        {
+            return Result<void>();
+        }
+        return Result<void>(ResourceTraits<Type>::release(rd_interface, id_));
+    }
+
+private:
+    RD_INTERFACE* rd_interface_;
+    RD_ID id_;
+    unsigned int serial_;
+};
+
+typedef Handle<RD_RESOURCE_IMAGE> Image;
+typedef Handle<RD_RESOURCE_IMAGE_WRITE> ImageWrite;
+typedef Handle<RD_RESOURCE_IMAGE_LIST> ImageList;
+typedef Handle<RD_RESOURCE_IMAGE_LIST_WRITE> ImageListWrite;
+typedef Handle<RD_RESOURCE_ANIMATION> Animation;
+typedef Handle<RD_RESOURCE_FONT> Font;
+typedef Handle<RD_RESOURCE_STRING_WRITE> StringWrite;
+typedef Handle<RD_RESOURCE_CHARACTER_WRITE> CharacterWrite;
+typedef Handle<RD_RESOURCE_TEXT_WINDOW> TextWindow;
+typedef Handle<RD_RESOURCE_LINE_GRAPH> LineGraph;
+typedef Handle<RD_RESOURCE_BAR_GRAPH> BarGraph;
+typedef Handle<RD_RESOURCE_TOUCH> Touch;
+
+/* ================================================================== */
+/* open connection to one display, closed by the destructor
+   every member is an inline call of the Rd_* command of the same name */
+class Interface
+{
+public:
+    explicit Interface(const char* port_name) : rd_interface_(RdInterfaceInit(port_name)) {}
+    /* take ownership of an interface opened by the C API, e.g. RdBroadcastInit */
+    explicit Interface(RD_INTERFACE* rd_interface) : rd_interface_(rd_interface) {}
+    ~Interface()
+    {
+        if (rd_interface_)
+        {
+            RdInterfaceClose(rd_interface_);
+        }
+    }
+    Interface(Interface&& other) : rd_interface_(other.rd_interface_)
+    {
+        other.rd_interface_ = NULL;
+    }
+    Interface(const Interface&) = delete;
+    Interface& operator=(const Interface&) = delete;
+
+    bool isOpen() const { return rd_interface_ != NULL; }
+    /* handle for the C API */
+    RD_INTERFACE* get() const { return rd_interface_; }
+
+    /* layer commands */
+    Result<void> setLayerEnable(RD_ID layer_id, bool enable)
+    {
+        return Rd_SetLayerEnable(rd_interface_, layer_id, enable ? RD_TRUE : RD_FALSE);
+    }
+    Result<void> setLayerOriginAndSize(RD_ID layer_id, RD_POSITION position, RD_SIZE size)
+    {
+        return Rd_SetLayerOriginAndSize(rd_interface_, layer_id, position, size);
+    }
+    Result<void> setLayerBackColor(RD_ID layer_id, RD_COLOR back_color)
+    {
+        return Rd_SetLayerBackColor(rd_interface_, layer_id, back_color);
+    }
+    Result<void> setLayerTransparency(RD_ID layer_id, RD_BYTE transparency_percentage)
+    {
+        return Rd_SetLayerTransparency(rd_interface_, layer_id, transparency_percentage);
+    }
+    Result<void> layerClear(RD_ID layer_id)
+    {
+        return Rd_LayerClear(rd_interface_, layer_id);
+    }
+    Result<void> layerWriteRawPixels(RD_ID layer_id, RD_POSITION position, RD_SIZE pixel_size, const RD_COLOR* pixels)
+    {
+        return Rd_LayerWriteRawPixels(rd_interface_, layer_id, position, pixel_size, pixels);
+    }
+    Result<void> composeLayersToPage(RD_ID page_id)
+    {
+        return Rd_ComposeLayersToPage(rd_interface_, page_id);
+    }
+    Result<void> pageToScreen(RD_ID page_id)
+    {
+        return Rd_PageToScreen(rd_interface_, page_id);
+    }
+
+    /* image commands */
+    Result<Image> imageLoad(const char* image_label)
+    {
+        RD_ID id = 0;
+        int ret = Rd_ImageLoad(rd_interface_, image_label, &id);
+        return handle<RD_RESOURCE_IMAGE>(ret, id);
+    }
+    Result<ImageWrite> imageWrite(RD_ID layer_id, RD_ID image_id, RD_POSITION position)
+    {
+        RD_ID id = 0;
+        int ret = Rd_ImageWrite(rd_interface_, layer_id, image_id, position, &id);
+        return handle<RD_RESOURCE_IMAGE_WRITE>(ret, id);
+    }
+    Result<void> imageMove(const ImageWrite& image_write, RD_POSITION position)
+    {
+        return Rd_ImageMove(rd_interface_, image_write.id(), position);
+    }
+    Result<ImageList> imageListLoad(const char* prefix, RD_UWORD index_start, RD_UWORD index_step, RD_UWORD index_count)
+    {
+        RD_ID id = 0;
+        int ret = Rd_ImageListLoad(rd_interface_, prefix, index_start, index_step, index_count, &id);
+        return handle<RD_RESOURCE_IMAGE_LIST>(ret, id);
+    }
+    Result<ImageListWrite> imageListWrite(RD_ID layer_id, RD_POSITION position, RD_ID image_list_id, RD_UWORD image_index)
+    {
+        RD_ID id = 0;
+        int ret = Rd_ImageListWrite(rd_interface_, layer_id, position, image_list_id, image_index, &id);
+        return handle<RD_RESOURCE_IMAGE_LIST_WRITE>(ret, id);
+    }
+    Result<void> imageListReplace(const ImageListWrite& image_list_write, RD_UWORD image_index)
+    {
+        return Rd_ImageListReplace(rd_interface_, image_list_write.id(), image_index);
+    }
+    Result<Animation> animationPlay(RD_ID layer_id, RD_POSITION position, RD_ID image_list_id, RD_UWORD frequency)
+    {
+        RD_ID id = 0;
+        int ret = Rd_AnimationPlay(rd_interface_, layer_id, position, image_list_id, frequency, &id);
+        return handle<RD_RESOURCE_ANIMATION>(ret, id);
+    }
+
+    /* text commands */
+    Result<Font> fontLoad(const char* font_label)
+    {
+        RD_ID id = 0;
+        int ret = Rd_FontLoad(rd_interface_, font_label, &id);
+        return handle<RD_RESOURCE_FONT>(ret, id);
+    }
+    Result<StringWrite> stringWrite(RD_ID layer_id, RD_POSITION position, RD_ID font_id, RD_COLOR color,
+        RD_HDIRECTION hdirection, const char* data)
+    {
+        RD_ID id = 0;
+        int ret = Rd_StringWrite(rd_interface_, layer_id, position, font_id, color, hdirection, data, &id);
+        return handle<RD_RESOURCE_STRING_WRITE>(ret, id);
+    }
+    Result<void> stringReplace(const StringWrite& string_write, const char* data)
+    {
+        return Rd_StringReplace(rd_interface_, string_write.id(), data);
+    }
+    Result<CharacterWrite> characterWrite(RD_ID layer_id, RD_POSITION position, RD_ID font_id, RD_COLOR color, RD_BYTE c)
+    {
+        RD_ID id = 0;
+        int ret = Rd_CharacterWrite(rd_interface_, layer_id, position, font_id, color, c, &id);
+        return handle<RD_RESOURCE_CHARACTER_WRITE>(ret, id);
+    }
+    Result<void> characterReplace(const CharacterWrite& character_write, RD_BYTE c)
+    {
+        return Rd_CharacterReplace(rd_interface_, character_write.id(), c);
+    }
+    Result<TextWindow> textWindowCreate(RD_ID layer_id, RD_POSITION position, RD_SIZE size, RD_ID font_id,
+        RD_COLOR font_color, RD_HDIRECTION scroll_direction)
+    {
+        RD_ID id = 0;
+        int ret = Rd_TextWindowCreate(rd_interface_, layer_id, position, size, font_id, font_color,
+            scroll_direction, &id);
+        return handle<RD_RESOURCE_TEXT_WINDOW>(ret, id);
+    }
+    Result<void> textWindowInsertText(const TextWindow& text_window, const char* data)
+    {
+        return Rd_TextWindowInsertText(rd_interface_, text_window.id(), data);
+    }
+
+    /* graph commands */
+    Result<LineGraph> lineGraphCreateWindow(RD_ID layer_id, RD_POSITION position, RD_SIZE size,
+        RD_BYTE line_width, RD_BYTE line_glow_width, bool autocompose)
+    {
+        RD_ID id = 0;
+        int ret = Rd_LineGraphCreateWindow(rd_interface_, layer_id, position, size, line_width,
+            line_glow_width, autocompose ? RD_TRUE : RD_FALSE, &id);
+        return handle<RD_RESOURCE_LINE_GRAPH>(ret, id);
+    }
+    Result<void> lineGraphInsertPoints(const LineGraph& graph, RD_COLOR point_color, RD_UWORD point_length,
+        const RD_POSITION* points)
+    {
+        return Rd_LineGraphInsertPoints(rd_interface_, graph.id(), point_color, point_length, points);
+    }
+    Result<BarGraph> barGraphCreateWindow(RD_ID layer_id, RD_POSITION position, RD_SIZE size,
+        RD_BYTE stack_size, RD_DIRECTION stack_direction, bool autocompose)
+    {
+        RD_ID id = 0;
+        int ret = Rd_BarGraphCreateWindow(rd_interface_, layer_id, position, size, stack_size,
+            stack_direction, autocompose ? RD_TRUE : RD_FALSE, &id);
+        return handle<RD_RESOURCE_BAR_GRAPH>(ret, id);
+    }
+    Result<void> barGraphInsertStacks(const BarGraph& graph, RD_BYTE no_of_stack, RD_ID image_id)
+    {
+        return Rd_BarGraphInsertStacks(rd_interface_, graph.id(), no_of_stack, image_id);
+    }
+    Result<void> barGraphRemoveStacks(const BarGraph& graph, RD_BYTE no_of_stack)
+    {
+        return Rd_BarGraphRemoveStacks(rd_interface_, graph.id(), no_of_stack);
+    }
+
+    /* touch map commands */
+    Result<Touch> touchMapRectangle(RD_POSITION position, RD_SIZE size, const char* label)
+    {
+        RD_ID id = 0;
+        int ret = Rd_TouchMapRectangle(rd_interface_, position, size, label, &id);
+        return handle<RD_RESOURCE_TOUCH>(ret, id);
+    }
+    Result<Touch> touchMapCircle(RD_POSITION position, RD_UWORD outer_circle_radius, RD_UWORD inner_circle_radius,
+        const char* label)
+    {
+        RD_ID id = 0;
+        int ret = Rd_TouchMapCircle(rd_interface_, position, outer_circle_radius, inner_circle_radius, label, &id);
+        return handle<RD_RESOURCE_TOUCH>(ret, id);
+    }
+    Result<void> touchMapClear()
+    {
+        return Rd_TouchMapClear(rd_interface_);
+    }
+
+    /* information commands */
+    Result<std::string> systemInfo(RD_GET_VERSION_TYPE type)
+    {
+        const char* data = NULL;
+        int length = 0;
+        int ret = Rd_SystemInfoView(rd_interface_, type, &data, &length);
+        return text(ret, data, length);
+    }
+    Result<std::string> testEcho(const char* label)
+    {
+        const char* data = NULL;
+        int length = 0;
+        int ret = Rd_TestEchoView(rd_interface_, label, &data, &length);
+        return text(ret, data, length);
+    }
+    Result<void> reset()
+    {
+        return Rd_Reset(rd_interface_);
+    }
+    Result<void> setBackLightBrightness(RD_UWORD backlight_brightness)
+    {
+        return Rd_SetBackLightBrightness(rd_interface_, backlight_brightness);
+    }
+
+private:
+    template <RD_RESOURCE_TYPE Type> Result<Handle<Type> > handle(int ret, RD_ID id)
+    {
+        if (ret < 0)
+        {
+            return Result<Handle<Type> >::failure(ret);
+        }
+        return Handle<Type>(rd_interface_, id);
+    }
+    static Result<std::string> text(int ret, const char* data, int length)
+    {
+        if (ret < 0)
+        {
+            return Result<std::string>::failure(ret);
+        }
+        return std::string(data, length);
+    }
+
+    RD_INTERFACE* rd_interface_;
+};
+
+}
+
+#endif
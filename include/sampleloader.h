@@ -20,3 +20,5 @@
 		int image_write_id;			/* image write id returned from Rd_ImageWrite() */
 	};
 
+/* enable layer of image, load image and write it */
+int enableloadwrite(RD_INTERFACE* rd_interface, struct image_object* local);
@@ -0,0 +1,372 @@
+/*
+ * rdpack.c
+ *
+ * Offline tool building a packed asset file for RdPackOpen()
+ *
+ * usage: rdpack [-c] [-j threads] output.rdp image.bmp|directory ...
+ *   -c          crop every image to its non transparent pixels
+ *   -j threads  number of worker threads, default is one per core
+ *
+ * Every 32 bpp BMP is decoded and converted to RD_COLOR order once, here,
+ * so the target only has to map the pack and hand the pixels to
+ * Rd_LayerWriteRawPixels. The label of an image is its file name without
+ * directory and .bmp extension, e.g. "images/blue-on.bmp" is "blue-on".
+ *
+ * Images are decoded, converted, cropped and hashed by a pool of worker
+ * threads. The main thread writes finished images to the pack in input
+ * order while later images are still being processed.
+ */
+#include <stdio.h>
+#include <dirent.h>
+#include <pthread.h>
+#include "../include/ripdraw.h"
+
+#define MAX_JOBS 4096		/* maximum number of images in one pack */
+#define JOB_PATH_LENGTH 1024	/* maximum length of image path */
+#define JOBS_AHEAD 4		/* finished images kept in memory per worker */
+
+	/* one image to preprocess */
+	struct pack_job
+	{
+		char path[JOB_PATH_LENGTH];		/* image file */
+		char label[RD_PACK_LABEL_LENGTH];	/* label in pack index */
+		RD_BITMAP bitmap;			/* converted and cropped pixels */
+		RD_POSITION origin;			/* crop origin */
+		unsigned int hash;			/* RdPackHash of pixels */
+		int ret;				/* result of preprocessing */
+		int done;				/* set by worker when finished */
+	};
+
+	/* jobs shared by worker threads and writer */
+	struct pack_pool
+	{
+		struct pack_job* jobs;
+		int count;				/* number of jobs */
+		int next;				/* next job to take by a worker */
+		int written;				/* jobs written by the main thread */
+		int ahead;				/* how far workers may run ahead of writer */
+		int crop;				/* crop images */
+		int abort;				/* writer failed, workers stop */
+		pthread_mutex_t lock;
+		pthread_cond_t changed;
+	};
+
+/* ================================================================== */
+/* label of image file: file name without directory and extension */
+static int rdpack_label(const char* path, char* label)
+{
+    const char* name = strrchr(path, '/');
+    const char* ext;
+    size_t len;
+    name = name ? name + 1 : path;
+    ext = strrchr(name, '.');
+    len = ext ? (size_t) (ext - name) : strlen(name);
+    /* a truncated label could collide with another one */
+    if (len >= RD_PACK_LABEL_LENGTH)
+    {
+        fprintf(stderr, "%s: label longer than %d characters\n", path, RD_PACK_LABEL_LENGTH - 1);
+        return -1;
+    }
+    memcpy(label, name, len);
+    label[len] = 0;
+    return 0;
+}
+
+/* ================================================================== */
+/* crop bitmap in place to the bounding box of pixels with alpha */
+static void rdpack_crop(RD_BITMAP* bitmap, RD_POSITION* origin)
+{
+    int x, y, left, top, right, bottom, width;
+    const RD_COLOR* pixels = bitmap->pixels;
+
+    left = bitmap->size.width;
+    top = bitmap->size.height;
+    right = -1;
+    bottom = -1;
+    for (y = 0; y < bitmap->size.height; y++)
+    {
+        for (x = 0; x < bitmap->size.width; x++)
+        {
+            if (pixels[y * bitmap->size.width + x].alpha != 0)
+            {
+                left = (x < left) ? x : left;
+                right = (x > right) ? x : right;
+                top = (y < top) ? y : top;
+                bottom = y;
+            }
+        }
+    }
+    if (right < 0)
+    {
+        /* fully transparent, keep one pixel */
+        left = right = top = bottom = 0;
+    }
+    width = right - left + 1;
+    /* rows only move towards the start of the buffer */
+    for (y = top; y <= bottom; y++)
+    {
+        memmove(bitmap->pixels + (y - top) * width, bitmap->pixels + y * bitmap->size.width + left, width * sizeof(RD_COLOR));
+    }
+    bitmap->size = Rd_Size(width, bottom - top + 1);
+    *origin = Rd_Position(left, top);
+}
+
+/* ================================================================== */
+/* decode, convert, crop and hash one image */
+static void rdpack_process(struct pack_pool* pool, struct pack_job* job)
+{
+    job->origin = Rd_Position(0, 0);
+    job->ret = RdBitmapLoad(job->path, &job->bitmap);
+    if (job->ret < 0)
+    {
+        return;
+    }
+    if (pool->crop)
+    {
+        rdpack_crop(&job->bitmap, &job->origin);
+    }
+    job->hash = RdPackHash((const RD_BYTE*) job->bitmap.pixels,
+        job->bitmap.size.width * job->bitmap.size.height * sizeof(RD_COLOR));
+}
+
+/* ================================================================== */
+/* worker thread: take next job until all are taken */
+static void* rdpack_worker(void* arg)
+{
+    struct pack_pool* pool = (struct pack_pool*) arg;
+    struct pack_job* job;
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->abort && pool->next < pool->count)
+    {
+        /* bound memory held by finished but unwritten images */
+        if (pool->next >= pool->written + pool->ahead)
+        {
+            pthread_cond_wait(&pool->changed, &pool->lock);
+            continue;
+        }
+        job = &pool->jobs[pool->next++];
+        pthread_mutex_unlock(&pool->lock);
+
+        rdpack_process(pool, job);
+
+        pthread_mutex_lock(&pool->lock);
+        job->done = 1;
+        pthread_cond_broadcast(&pool->changed);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/* ================================================================== */
+/* add job for an image file */
+static int rdpack_add_job(struct pack_pool* pool, const char* path)
+{
+    if (pool->count == MAX_JOBS)
+    {
+        fprintf(stderr, "too many images, maximum is %d\n", MAX_JOBS);
+        return -1;
+    }
+    if (rdpack_label(path, pool->jobs[pool->count].label) != 0)
+    {
+        return -1;
+    }
+    snprintf(pool->jobs[pool->count].path, JOB_PATH_LENGTH, "%s", path);
+    pool->count++;
+    return 0;
+}
+
+/* ================================================================== */
+/* compare names for qsort */
+static int rdpack_name_compare(const void* a, const void* b)
+{
+    return strcmp(*(char* const*) a, *(char* const*) b);
+}
+
+/* ================================================================== */
+/* add job for every BMP file of a directory, in name order */
+static int rdpack_add_directory(struct pack_pool* pool, const char* path, DIR* dir)
+{
+    int ret = 0, count = 0, i;
+    char* names[MAX_JOBS];
+    char file[JOB_PATH_LENGTH];
+    struct dirent* entry;
+
+    while ((entry = readdir(dir)) != NULL && ret == 0)
+    {
+        int len = strlen(entry->d_name);
+        if (len > 4 && strcmp(entry->d_name + len - 4, ".bmp") == 0)
+        {
+            /* a partial set is never packed */
+            if (count == MAX_JOBS)
+            {
+                fprintf(stderr, "%s: too many images, maximum is %d\n", path, MAX_JOBS);
+                ret = -1;
+                break;
+            }
+            names[count] = strdup(entry->d_name);
+            if (!names[count])
+            {
+                fprintf(stderr, "unable to allocate memory\n");
+                ret = -1;
+                break;
+            }
+            count++;
+        }
+    }
+    qsort(names, count, sizeof(char*), rdpack_name_compare);
+    for (i = 0; i < count; i++)
+    {
+        if (ret == 0)
+        {
+            snprintf(file, sizeof(file), "%s/%s", path, names[i]);
+            ret = rdpack_add_job(pool, file);
+        }
+        free(names[i]);
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+    int ret = 0;
+    int threads = 0;
+    int started = 0;
+    const char* output;
+    RD_PACK_WRITER writer;
+    DIR* dir;
+    struct pack_pool pool;
+    struct pack_job* job;
+    pthread_t* workers;
+
+    memset(&pool, 0, sizeof(pool));
+    for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-c") == 0)
+        {
+            pool.crop = 1;
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (argc - i < 2)
+    {
+        fprintf(stderr, "usage: %s [-c] [-j threads] output.rdp image.bmp|directory ...\n", argv[0]);
+        return 1;
+    }
+    output = argv[i];
+    if (threads <= 0)
+    {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (threads > 0) ? threads : 1;
+    }
+
+    pool.jobs = (struct pack_job*) calloc(MAX_JOBS, sizeof(struct pack_job));
+    workers = (pthread_t*) calloc(threads, sizeof(pthread_t));
+    if (!pool.jobs || !workers)
+    {
+        fprintf(stderr, "unable to allocate memory\n");
+        return 1;
+    }
+
+    /* collect all images first, workers then take them in order */
+    for (i = i + 1; i < argc && ret == 0; i++)
+    {
+        dir = opendir(argv[i]);
+        if (dir)
+        {
+            ret = rdpack_add_directory(&pool, argv[i], dir);
+            closedir(dir);
+        }
+        else
+        {
+            ret = rdpack_add_job(&pool, argv[i]);
+        }
+    }
+    if (ret != 0) return 1;
+
+    ret = RdPackWriterOpen(&writer, output);
+    if (ret != 0) return 1;
+
+    pool.ahead = threads * JOBS_AHEAD;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.changed, NULL);
+    for (started = 0; started < threads; started++)
+    {
+        if (pthread_create(&workers[started], NULL, rdpack_worker, &pool) != 0)
+        {
+            break;
+        }
+    }
+
+    /* write images in input order as soon as each one is finished */
+    for (job = pool.jobs; job < pool.jobs + pool.count; job++)
+    {
+        if (started == 0)
+        {
+            /* no thread available, process each image in this thread before writing it */
+            rdpack_process(&pool, job);
+            job->done = 1;
+        }
+        pthread_mutex_lock(&pool.lock);
+        while (!job->done)
+        {
+            pthread_cond_wait(&pool.changed, &pool.lock);
+        }
+        pthread_mutex_unlock(&pool.lock);
+
+        if (ret == 0)
+        {
+            ret = job->ret;
+        }
+        if (ret == 0)
+        {
+            printf("%s: %dx%d at %d,%d\n", job->label, job->bitmap.size.width, job->bitmap.size.height,
+                job->origin.x, job->origin.y);
+            ret = RdPackWriterAddHashed(&writer, job->label, &job->bitmap, job->origin, job->hash);
+        }
+        RdBitmapFree(&job->bitmap);
+
+        pthread_mutex_lock(&pool.lock);
+        pool.written++;
+        if (ret != 0)
+        {
+            pool.abort = 1;
+        }
+        pthread_cond_broadcast(&pool.changed);
+        pthread_mutex_unlock(&pool.lock);
+        if (ret != 0)
+        {
+            break;
+        }
+    }
+
+    for (i = 0; i < started; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    /* free images finished after an error */
+    for (job = pool.jobs; job < pool.jobs + pool.count; job++)
+    {
+        RdBitmapFree(&job->bitmap);
+    }
+    pthread_mutex_destroy(&pool.lock);
+    pthread_cond_destroy(&pool.changed);
+    free(workers);
+    free(pool.jobs);
+
+    if (RdPackWriterClose(&writer) != 0 || ret != 0)
+    {
+        remove(output);
+        return 1;
+    }
+    printf("Done!\n");
+    return 0;
+}
@@ -0,0 +1,478 @@
+/* ripdraw-batch.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * batch: deferred commands, optimised before they are sent
+ */
+#include "ripdraw.h"
+
+#define RD_PROTO_POS_SEQ			2
+#define RD_PROTO_POS_BYTE_0			6
+
+RD_UWORD rd_checksum(RD_BYTE* data, int length);
+int rd_buffer_check_and_allocate(RD_INTERFACE_BUFFER* buffer, int required_capacity);
+int rd_cmd_request_send(RD_INTERFACE* rd_interface);
+int rd_cmd_response_defer(RD_INTERFACE* rd_interface);
+int rd_cmd_response_drain(RD_INTERFACE* rd_interface);
+void rd_prefetch_complete(RD_INTERFACE* rd_interface);
+
+/* how a command takes part in a batch */
+typedef enum _RD_BATCH_KIND
+{
+    /* returns an id or data, queued commands are sent first */
+    RD_BATCH_DIRECT = 0,
+    /* does not depend on queued commands, sent at once */
+    RD_BATCH_HOIST,
+    /* queued and sent as it is */
+    RD_BATCH_KEEP,
+    /* release or delete, queued and sent as it is, loads are not sent ahead of it */
+    RD_BATCH_RELEASE,
+    /* absolute update of the id in front of the payload, only the last one is sent */
+    RD_BATCH_LAST,
+    /* absolute update without id */
+    RD_BATCH_LAST_ANY,
+    /* compose of the page in front of the payload, only the last one is sent */
+    RD_BATCH_COMPOSE,
+    /* queued, nothing is moved across it */
+    RD_BATCH_BARRIER
+} RD_BATCH_KIND;
+
+/* batch kind of queued commands and the command deleting their id */
+static const struct
+{
+    RD_COMMAND_IDS cmd_id;
+    RD_BATCH_KIND kind;
+    int deleted_by;
+} rd_batch_commands[] =
+{
+    { Cmd_SetLayerEnable, RD_BATCH_LAST, 0 },
+    { Cmd_SetLayerOriginAndSize, RD_BATCH_LAST, 0 },
+    { Cmd_SetLayerBackColor, RD_BATCH_LAST, 0 },
+    { Cmd_SetLayerTransparency, RD_BATCH_LAST, 0 },
+    { Cmd_LayerClear, RD_BATCH_BARRIER, 0 },
+    { Cmd_LayerMove, RD_BATCH_KEEP, 0 },
+    { Cmd_LayerWriteRawPixels, RD_BATCH_KEEP, 0 },
+    { Cmd_ComposeLayersToPage, RD_BATCH_COMPOSE, 0 },
+    { Cmd_PageToScreen, RD_BATCH_BARRIER, 0 },
+    { Cmd_PartialComposeLayersToScreen, RD_BATCH_BARRIER, 0 },
+    { Cmd_ImageLoad, RD_BATCH_HOIST, 0 },
+    { Cmd_ImageRelease, RD_BATCH_RELEASE, 0 },
+    { Cmd_ImageDelete, RD_BATCH_RELEASE, 0 },
+    { Cmd_ImageMove, RD_BATCH_LAST, Cmd_ImageDelete },
+    { Cmd_ImageListLoad, RD_BATCH_HOIST, 0 },
+    { Cmd_ImageListRelease, RD_BATCH_RELEASE, 0 },
+    { Cmd_ImageListReplace, RD_BATCH_LAST, Cmd_ImageListDelete },
+    { Cmd_ImageListDelete, RD_BATCH_RELEASE, 0 },
+    { Cmd_AnimationStop, RD_BATCH_KEEP, Cmd_AnimationDelete },
+    { Cmd_AnimationContinue, RD_BATCH_KEEP, Cmd_AnimationDelete },
+    { Cmd_AnimationDelete, RD_BATCH_RELEASE, 0 },
+    { Cmd_FontLoad, RD_BATCH_HOIST, 0 },
+    { Cmd_FontRelease, RD_BATCH_RELEASE, 0 },
+    { Cmd_SetFontPadding, RD_BATCH_KEEP, 0 },
+    { Cmd_StringReplace, RD_BATCH_LAST, Cmd_StringDelete },
+    { Cmd_StringDelete, RD_BATCH_RELEASE, 0 },
+    { Cmd_CharacterReplace, RD_BATCH_LAST, Cmd_CharacterDelete },
+    { Cmd_CharacterDelete, RD_BATCH_RELEASE, 0 },
+    { Cmd_TextWindowSetInsertionPoint, RD_BATCH_KEEP, Cmd_TextWindowDelete },
+    { Cmd_TextWindowInsertText, RD_BATCH_KEEP, Cmd_TextWindowDelete },
+    { Cmd_TextWindowDelete, RD_BATCH_RELEASE, 0 },
+    { Cmd_LineGraphInsertPoints, RD_BATCH_KEEP, Cmd_LineGraphDeleteWindow },
+    { Cmd_LineGraphMove, RD_BATCH_KEEP, Cmd_LineGraphDeleteWindow },
+    { Cmd_LineGraphDeleteWindow, RD_BATCH_RELEASE, 0 },
+    { Cmd_BarGraphInsertStacks, RD_BATCH_KEEP, Cmd_BarGraphDeleteWindow },
+    { Cmd_BarGraphRemoveStacks, RD_BATCH_KEEP, Cmd_BarGraphDeleteWindow },
+    { Cmd_BarGraphDeleteWindow, RD_BATCH_RELEASE, 0 },
+    { Cmd_TouchMapDelete, RD_BATCH_RELEASE, 0 },
+    { Cmd_TouchMapClear, RD_BATCH_RELEASE, 0 },
+    { Cmd_SystemInfo, RD_BATCH_HOIST, 0 },
+    { Cmd_GetMaxBackLightBrightness, RD_BATCH_HOIST, 0 },
+    { Cmd_SetBackLightBrightness, RD_BATCH_LAST_ANY, 0 }
+};
+
+#define RD_BATCH_COMMAND_COUNT ((int) (sizeof(rd_batch_commands) / sizeof(rd_batch_commands[0])))
+
+/* ================================================================== */
+/* index of a command in rd_batch_commands, -1 when it is sent directly */
+static int rd_batch_command(int cmd_id)
+{
+    int i;
+    for (i = 0; i < RD_BATCH_COMMAND_COUNT; i++)
+    {
+        if ((int) rd_batch_commands[i].cmd_id == cmd_id)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* ================================================================== */
+/* batch kind of a command */
+static RD_BATCH_KIND rd_batch_kind(int cmd_id)
+{
+    int index = rd_batch_command(cmd_id);
+    return (index < 0) ? RD_BATCH_DIRECT : rd_batch_commands[index].kind;
+}
+
+/* ================================================================== */
+/* RdBatchBegin */
+int RdBatchBegin(RD_INTERFACE* rd_interface)
+{
+    _RD_CHECK_INTERFACE();
+
+#ifdef RD_NO_HEAP
+    fprintf(stderr, "batch needs heap memory\n");
+    return -0200102;
+#endif
+    /* members of a broadcast number their frames themselves */
+    if (rd_interface->broadcast)
+    {
+        fprintf(stderr, "batch needs a serial interface\n");
+        return -0200102;
+    }
+    if (rd_interface->batch == NULL)
+    {
+        rd_interface->batch = (RD_BATCH*) malloc(sizeof(RD_BATCH));
+        if (!rd_interface->batch)
+        {
+            fprintf(stderr, "unable to allocate memory\n");
+            return -0200101;
+        }
+        memset(rd_interface->batch, 0, sizeof(RD_BATCH));
+    }
+    rd_interface->batch->active = 1;
+    return 0;
+}
+
+/* ================================================================== */
+/* 1 when the request just encoded is queued instead of sent */
+int rd_batch_defers(RD_INTERFACE* rd_interface, int cmd_id)
+{
+    RD_BATCH_KIND kind;
+
+    if (rd_interface->batch == NULL || !rd_interface->batch->active
+        || rd_interface->async_phase != RD_ASYNC_NONE || rd_interface->replaying)
+    {
+        return 0;
+    }
+    kind = rd_batch_kind(cmd_id);
+    return kind != RD_BATCH_DIRECT && kind != RD_BATCH_HOIST;
+}
+
+/* ================================================================== */
+/* 1 when a release or delete is queued, a load may need the memory it frees */
+static int rd_batch_releases(const RD_BATCH* batch)
+{
+    int i;
+    for (i = 0; i < batch->count; i++)
+    {
+        if (rd_batch_kind(batch->entries[i].cmd_id) == RD_BATCH_RELEASE)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* send queued commands before a command depending on them is encoded */
+int rd_batch_submit_before(RD_INTERFACE* rd_interface, int cmd_id)
+{
+    RD_BATCH_KIND kind;
+
+    if (rd_interface->batch == NULL || !rd_interface->batch->active || rd_interface->batch->count == 0
+        || rd_interface->async_phase != RD_ASYNC_NONE || rd_interface->replaying)
+    {
+        return 0;
+    }
+    kind = rd_batch_kind(cmd_id);
+    /* sent ahead of pure updates only */
+    if (kind == RD_BATCH_HOIST && !rd_batch_releases(rd_interface->batch))
+    {
+        return 0;
+    }
+    if (kind != RD_BATCH_DIRECT && kind != RD_BATCH_HOIST)
+    {
+        return 0;
+    }
+    return RdBatchSubmit(rd_interface);
+}
+
+/* ================================================================== */
+/* queue the request just encoded */
+int rd_batch_queue(RD_INTERFACE* rd_interface)
+{
+    int ret;
+    RD_BATCH* batch = rd_interface->batch;
+    RD_BATCH_ENTRY* entry;
+
+    if (batch->count == batch->capacity)
+    {
+        int capacity = batch->capacity ? batch->capacity * 2 : 64;
+        RD_BATCH_ENTRY* tmp = (RD_BATCH_ENTRY*) realloc(batch->entries, capacity * sizeof(RD_BATCH_ENTRY));
+        if (!tmp)
+        {
+            fprintf(stderr, "unable to allocate memory\n");
+            return -0200101;
+        }
+        batch->entries = tmp;
+        batch->capacity = capacity;
+    }
+    ret = rd_buffer_check_and_allocate(&batch->frames, batch->frames.size + rd_interface->request.size);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    entry = &batch->entries[batch->count++];
+    entry->cmd_id = rd_interface->last_cmd_id;
+    entry->offset = batch->frames.size;
+    entry->length = rd_interface->request.size;
+    entry->dropped = 0;
+    memcpy(batch->frames.ptr + batch->frames.size, rd_interface->request.ptr, rd_interface->request.size);
+    batch->frames.size += rd_interface->request.size;
+    batch->commands++;
+    batch->queued = 1;
+    return 0;
+}
+
+/* ================================================================== */
+/* first uword of the payload, the layer, page or write a command is for */
+static RD_UWORD rd_batch_target(const RD_BATCH* batch, const RD_BATCH_ENTRY* entry)
+{
+    if (entry->length < RD_PROTO_POS_BYTE_0 + 2 + 2)
+    {
+        return 0;
+    }
+    return *((RD_UWORD*) (batch->frames.ptr + entry->offset + RD_PROTO_POS_BYTE_0));
+}
+
+/* ================================================================== */
+/* 1 when a later command makes entry i unobservable */
+static int rd_batch_superseded(const RD_BATCH* batch, int i)
+{
+    const RD_BATCH_ENTRY* entry = &batch->entries[i];
+    const RD_BATCH_ENTRY* later;
+    int index = rd_batch_command(entry->cmd_id);
+    RD_BATCH_KIND kind = rd_batch_commands[index].kind;
+    RD_BATCH_KIND later_kind;
+    int j;
+
+    for (j = i + 1; j < batch->count; j++)
+    {
+        later = &batch->entries[j];
+        if (later->dropped)
+        {
+            continue;
+        }
+        later_kind = rd_batch_kind(later->cmd_id);
+        if (kind == RD_BATCH_COMPOSE)
+        {
+            /* page shown before it is composed again */
+            if (later_kind == RD_BATCH_BARRIER && later->cmd_id != Cmd_LayerClear)
+            {
+                return 0;
+            }
+            if (later->cmd_id == entry->cmd_id && rd_batch_target(batch, later) == rd_batch_target(batch, entry))
+            {
+                return 1;
+            }
+            continue;
+        }
+        /* a compose kept or a page shown sees the update */
+        if (later_kind == RD_BATCH_BARRIER || later_kind == RD_BATCH_COMPOSE)
+        {
+            return 0;
+        }
+        if (later->cmd_id == rd_batch_commands[index].deleted_by
+            && rd_batch_target(batch, later) == rd_batch_target(batch, entry))
+        {
+            return 1;
+        }
+        if (later->cmd_id == entry->cmd_id
+            && (kind == RD_BATCH_LAST_ANY
+                || (kind == RD_BATCH_LAST && rd_batch_target(batch, later) == rd_batch_target(batch, entry))))
+        {
+            return 1;
+        }
+        /* e.g. Rd_LayerMove or Rd_LayerWriteRawPixels work on the settings of their layer,
+           only other absolute updates do not see it */
+        if (kind == RD_BATCH_LAST && later_kind != RD_BATCH_LAST
+            && rd_batch_target(batch, later) == rd_batch_target(batch, entry))
+        {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* drop commands later ones make unobservable, composes first as they decide what is kept */
+static void rd_batch_optimise(RD_BATCH* batch)
+{
+    int i, pass;
+    RD_BATCH_KIND kind;
+
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (i = batch->count - 1; i >= 0; i--)
+        {
+            kind = rd_batch_kind(batch->entries[i].cmd_id);
+            if ((kind == RD_BATCH_COMPOSE) != (pass == 0) || kind == RD_BATCH_BARRIER)
+            {
+                continue;
+            }
+            batch->entries[i].dropped = rd_batch_superseded(batch, i);
+        }
+    }
+}
+
+/* ================================================================== */
+/* RdBatchSubmit */
+int RdBatchSubmit(RD_INTERFACE* rd_interface)
+{
+    int ret = 0, tmp, i;
+    RD_BATCH* batch;
+    RD_BATCH_ENTRY* entry;
+    _RD_CHECK_INTERFACE();
+
+    batch = rd_interface->batch;
+    if (batch == NULL || batch->count == 0)
+    {
+        return 0;
+    }
+    /* replies of loads prefetched come before the replies of the batch */
+    rd_prefetch_complete(rd_interface);
+    rd_batch_optimise(batch);
+    for (i = 0; i < batch->count && ret == 0; i++)
+    {
+        entry = &batch->entries[i];
+        if (entry->dropped)
+        {
+            continue;
+        }
+        ret = rd_buffer_check_and_allocate(&rd_interface->request, entry->length);
+        if (ret < 0)
+        {
+            break;
+        }
+        memcpy(rd_interface->request.ptr, batch->frames.ptr + entry->offset, entry->length);
+        rd_interface->request.size = entry->length;
+        /* numbered again, commands sent ahead of the queue took newer numbers */
+        rd_interface->seq_no++;
+        *((RD_UWORD*) (rd_interface->request.ptr + RD_PROTO_POS_SEQ)) = (RD_UWORD) rd_interface->seq_no;
+        *((RD_UWORD*) (rd_interface->request.ptr + entry->length - 2)) = rd_checksum(rd_interface->request.ptr, entry->length - 2);
+        rd_interface->last_cmd_id = entry->cmd_id;
+        ret = rd_cmd_request_send(rd_interface);
+        if (ret < 0)
+        {
+            break;
+        }
+        batch->sent++;
+        ret = rd_cmd_response_defer(rd_interface);
+    }
+    tmp = rd_cmd_response_drain(rd_interface);
+    if (ret == 0)
+    {
+        ret = tmp;
+    }
+    batch->count = 0;
+    batch->frames.size = 0;
+    if (ret < 0)
+    {
+        /* settings queued are in an unknown state */
+        RdStateCacheForget(rd_interface);
+    }
+    return ret;
+}
+
+/* ================================================================== */
+/* RdBatchEnd */
+int RdBatchEnd(RD_INTERFACE* rd_interface)
+{
+    int ret;
+    _RD_CHECK_INTERFACE();
+
+    ret = RdBatchSubmit(rd_interface);
+    if (rd_interface->batch)
+    {
+        rd_interface->batch->active = 0;
+    }
+    return ret;
+}
+
+#ifdef RD_BATCH_CHECK
+/* commands queued in order and whether the optimiser drops them, sequences end with cmd_id 0 */
+static const struct
+{
+    int cmd_id;
+    RD_UWORD target;
+    int dropped;
+} rd_batch_check_sequences[][5] =
+{
+    /* repeated move of a write */
+    { { Cmd_ImageMove, 1, 1 }, { Cmd_ImageMove, 1, 0 }, { 0, 0, 0 } },
+    /* moves of different writes */
+    { { Cmd_ImageMove, 1, 0 }, { Cmd_ImageMove, 2, 0 }, { 0, 0, 0 } },
+    /* update of a write deleted later */
+    { { Cmd_StringReplace, 3, 1 }, { Cmd_StringDelete, 3, 0 }, { 0, 0, 0 } },
+    /* other settings of the layer in between */
+    { { Cmd_SetLayerBackColor, 1, 1 }, { Cmd_SetLayerEnable, 1, 0 }, { Cmd_SetLayerBackColor, 1, 0 }, { 0, 0, 0 } },
+    /* relative move of the layer in between */
+    { { Cmd_SetLayerOriginAndSize, 1, 0 }, { Cmd_LayerMove, 1, 0 }, { Cmd_SetLayerOriginAndSize, 1, 0 }, { 0, 0, 0 } },
+    /* raw pixels of the layer in between */
+    { { Cmd_SetLayerTransparency, 1, 0 }, { Cmd_LayerWriteRawPixels, 1, 0 }, { Cmd_SetLayerTransparency, 1, 0 }, { 0, 0, 0 } },
+    /* raw pixels of another layer in between */
+    { { Cmd_SetLayerTransparency, 1, 1 }, { Cmd_LayerWriteRawPixels, 2, 0 }, { Cmd_SetLayerTransparency, 1, 0 }, { 0, 0, 0 } },
+    /* compose in between shows the first setting */
+    { { Cmd_SetLayerEnable, 1, 0 }, { Cmd_ComposeLayersToPage, 1, 0 }, { Cmd_SetLayerEnable, 1, 0 }, { 0, 0, 0 } },
+    /* composes of a page merged, not across a page shown */
+    { { Cmd_ComposeLayersToPage, 1, 1 }, { Cmd_ComposeLayersToPage, 1, 0 }, { 0, 0, 0 } },
+    { { Cmd_ComposeLayersToPage, 1, 0 }, { Cmd_PageToScreen, 1, 0 }, { Cmd_ComposeLayersToPage, 1, 0 }, { 0, 0, 0 } },
+    /* update dropped with its compose */
+    { { Cmd_SetLayerEnable, 1, 1 }, { Cmd_ComposeLayersToPage, 1, 1 }, { Cmd_SetLayerEnable, 1, 0 },
+        { Cmd_ComposeLayersToPage, 1, 0 }, { 0, 0, 0 } },
+    /* backlight */
+    { { Cmd_SetBackLightBrightness, 10, 1 }, { Cmd_SetBackLightBrightness, 20, 0 }, { 0, 0, 0 } }
+};
+
+/* ================================================================== */
+/* RdBatchCheck */
+int RdBatchCheck(void)
+{
+    int i, j, ret = 0;
+    RD_BATCH batch;
+    RD_BATCH_ENTRY entries[5];
+    RD_BYTE frames[5 * 10];
+
+    for (i = 0; i < (int) (sizeof(rd_batch_check_sequences) / sizeof(rd_batch_check_sequences[0])) && ret == 0; i++)
+    {
+        memset(&batch, 0, sizeof(batch));
+        memset(frames, 0, sizeof(frames));
+        batch.entries = entries;
+        batch.frames.ptr = frames;
+        /* frames of header, target and checksum */
+        for (j = 0; j < 5 && rd_batch_check_sequences[i][j].cmd_id; j++)
+        {
+            entries[j].cmd_id = rd_batch_check_sequences[i][j].cmd_id;
+            entries[j].offset = j * 10;
+            entries[j].length = 10;
+            entries[j].dropped = 0;
+            *((RD_UWORD*) (frames + j * 10)) = (RD_UWORD) entries[j].cmd_id;
+            *((RD_UWORD*) (frames + j * 10 + RD_PROTO_POS_BYTE_0)) = rd_batch_check_sequences[i][j].target;
+        }
+        batch.count = j;
+        rd_batch_optimise(&batch);
+        for (j = 0; j < batch.count; j++)
+        {
+            if (entries[j].dropped != rd_batch_check_sequences[i][j].dropped)
+            {
+                fprintf(stderr, "batch check: sequence %d, command %d %s\n", i + 1, j + 1,
+                    entries[j].dropped ? "dropped" : "kept");
+                ret = i + 1;
+            }
+        }
+    }
+    return ret;
+}
+#endif
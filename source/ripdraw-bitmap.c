@@ -0,0 +1,294 @@
+/* ripdraw-bitmap.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * host-side BMP decoding and pixel conversion for Rd_LayerWriteRawPixels
+ */
+#include "ripdraw.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RD_BITMAP_NEON
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define RD_BITMAP_SSSE3
+#endif
+
+#define RD_BMP_FILE_HEADER_SIZE		14
+#define RD_BMP_INFO_HEADER_SIZE		40
+#define RD_BMP_BI_RGB				0
+#define RD_BMP_BI_BITFIELDS			3
+
+/* ================================================================== */
+/* read little-endian values from unaligned memory */
+static unsigned int rd_bmp_get_u32(const RD_BYTE* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int) data[3] << 24);
+}
+
+static unsigned int rd_bmp_get_u16(const RD_BYTE* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+/* ================================================================== */
+/* swap blue and red of one row, BGRA to RGBA */
+static void rd_pixel_swizzle_row(RD_BYTE* dst, const RD_BYTE* src, int count)
+{
+    int i = 0;
+#if defined(RD_BITMAP_NEON)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t bgra = vld4q_u8(src + i * 4);
+        uint8x16_t tmp = bgra.val[0];
+        bgra.val[0] = bgra.val[2];
+        bgra.val[2] = tmp;
+        vst4q_u8(dst + i * 4, bgra);
+    }
+#elif defined(RD_BITMAP_SSSE3)
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i bgra = _mm_loadu_si128((const __m128i*) (src + i * 4));
+        _mm_storeu_si128((__m128i*) (dst + i * 4), _mm_shuffle_epi8(bgra, mask));
+    }
+#endif
+    /* remaining pixels, swap byte 0 and 2 of each 32 bit word */
+    for (; i < count; i++)
+    {
+        unsigned int p;
+        memcpy(&p, src + i * 4, 4);
+        p = (p & 0xFF00FF00) | ((p >> 16) & 0xFF) | ((p & 0xFF) << 16);
+        memcpy(dst + i * 4, &p, 4);
+    }
+}
+
+/* ================================================================== */
+/* RdPixelConvertBgra */
+void RdPixelConvertBgra(RD_COLOR* dst, const RD_BYTE* src, int count)
+{
+    rd_pixel_swizzle_row((RD_BYTE*) dst, src, count);
+}
+
+/* ================================================================== */
+/* extract one channel of a BI_BITFIELDS pixel and scale it to 8 bits */
+static RD_BYTE rd_bmp_channel(unsigned int pixel, unsigned int mask, RD_BYTE missing)
+{
+    unsigned int max;
+    if (mask == 0)
+    {
+        return missing;
+    }
+    while ((mask & 1) == 0)
+    {
+        mask >>= 1;
+        pixel >>= 1;
+    }
+    max = mask;
+    return (RD_BYTE) (((pixel & mask) * 255 + max / 2) / max);
+}
+
+/* ================================================================== */
+/* RdBitmapDecode */
+int RdBitmapDecode(const RD_BYTE* data, int length, RD_BITMAP* bitmap)
+{
+    unsigned int pixel_offset, header_size, compression;
+    unsigned int red_mask, green_mask, blue_mask, alpha_mask;
+    int width, height, top_down, row, i;
+    RD_COLOR* pixels;
+
+    if (data == NULL || bitmap == NULL)
+    {
+        fprintf(stderr, "bitmap should not NULL\n");
+        return -020101;
+    }
+    if (length < RD_BMP_FILE_HEADER_SIZE + RD_BMP_INFO_HEADER_SIZE || data[0] != 'B' || data[1] != 'M')
+    {
+        fprintf(stderr, "not a BMP file\n");
+        return -020102;
+    }
+    pixel_offset = rd_bmp_get_u32(data + 10);
+    header_size = rd_bmp_get_u32(data + 14);
+    width = (int) rd_bmp_get_u32(data + 18);
+    height = (int) rd_bmp_get_u32(data + 22);
+    compression = rd_bmp_get_u32(data + 30);
+    if (rd_bmp_get_u16(data + 28) != 32 || (compression != RD_BMP_BI_RGB && compression != RD_BMP_BI_BITFIELDS))
+    {
+        fprintf(stderr, "only uncompressed 32 bpp BMP supported\n");
+        return -020103;
+    }
+    top_down = height < 0;
+    if (top_down && height >= -0xFFFF)
+    {
+        height = -height;
+    }
+    /* 0xFFFF x 0xFFFF x 4 bytes exceeds 32 bits, the product is taken in 64 bits */
+    if (width <= 0 || height <= 0 || width > 0xFFFF || height > 0xFFFF
+        || pixel_offset > (unsigned int) length
+        || (long long) length - pixel_offset < (long long) width * height * 4)
+    {
+        fprintf(stderr, "invalid BMP size\n");
+        return -020104;
+    }
+
+    /* default 32 bpp layout is BGRA, the fourth byte of BI_RGB is reserved */
+    red_mask = 0x00FF0000;
+    green_mask = 0x0000FF00;
+    blue_mask = 0x000000FF;
+    alpha_mask = 0;
+    if (compression == RD_BMP_BI_BITFIELDS)
+    {
+        if (length < 70)
+        {
+            fprintf(stderr, "invalid BMP header\n");
+            return -020105;
+        }
+        /* masks follow the 40 byte info header in every header version */
+        red_mask = rd_bmp_get_u32(data + 54);
+        green_mask = rd_bmp_get_u32(data + 58);
+        blue_mask = rd_bmp_get_u32(data + 62);
+        alpha_mask = (header_size >= 56) ? rd_bmp_get_u32(data + 66) : 0;
+    }
+
+    pixels = (RD_COLOR*) malloc((size_t) width * height * sizeof(RD_COLOR));
+    if (!pixels)
+    {
+        fprintf(stderr, "unable to allocate memory\n");
+        return -020106;
+    }
+
+    for (row = 0; row < height; row++)
+    {
+        /* bottom-up rows are flipped while converting */
+        const RD_BYTE* src = data + pixel_offset + (top_down ? row : height - 1 - row) * width * 4;
+        RD_COLOR* dst = pixels + row * width;
+
+        if (red_mask == 0x00FF0000 && green_mask == 0x0000FF00 && blue_mask == 0x000000FF
+            && (alpha_mask == 0xFF000000 || alpha_mask == 0))
+        {
+            rd_pixel_swizzle_row((RD_BYTE*) dst, src, width);
+            if (alpha_mask == 0)
+            {
+                for (i = 0; i < width; i++)
+                {
+                    dst[i].alpha = 0xFF;
+                }
+            }
+        }
+        else
+        {
+            for (i = 0; i < width; i++)
+            {
+                unsigned int p = rd_bmp_get_u32(src + i * 4);
+                dst[i].red = rd_bmp_channel(p, red_mask, 0);
+                dst[i].green = rd_bmp_channel(p, green_mask, 0);
+                dst[i].blue = rd_bmp_channel(p, blue_mask, 0);
+                dst[i].alpha = rd_bmp_channel(p, alpha_mask, 0xFF);
+            }
+        }
+    }
+
+    bitmap->size = Rd_Size((RD_UWORD) width, (RD_UWORD) height);
+    bitmap->pixels = pixels;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdBitmapLoad */
+int RdBitmapLoad(const char* file_name, RD_BITMAP* bitmap)
+{
+    int ret;
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE file, mapping;
+    DWORD length;
+    const RD_BYTE* data;
+
+    file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "unable to open %s\n", file_name);
+        return -020201;
+    }
+    length = GetFileSize(file, NULL);
+    mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    data = mapping ? (const RD_BYTE*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!data)
+    {
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        fprintf(stderr, "unable to map %s\n", file_name);
+        return -020202;
+    }
+    ret = RdBitmapDecode(data, (int) length, bitmap);
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    int handle;
+    struct stat info;
+    void* data;
+
+    handle = open(file_name, O_RDONLY);
+    if (handle < 0)
+    {
+        fprintf(stderr, "unable to open %s\n", file_name);
+        return -020201;
+    }
+    if (fstat(handle, &info) < 0 || info.st_size == 0)
+    {
+        close(handle);
+        fprintf(stderr, "unable to map %s\n", file_name);
+        return -020202;
+    }
+    data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+    close(handle);
+    if (data == MAP_FAILED)
+    {
+        fprintf(stderr, "unable to map %s\n", file_name);
+        return -020202;
+    }
+    ret = RdBitmapDecode((const RD_BYTE*) data, (int) info.st_size, bitmap);
+    munmap(data, info.st_size);
+#endif
+    return ret;
+}
+
+/* ================================================================== */
+/* RdBitmapFree */
+int RdBitmapFree(RD_BITMAP* bitmap)
+{
+    if (bitmap)
+    {
+        RdFreeData(bitmap->pixels);
+        bitmap->pixels = NULL;
+        bitmap->size = Rd_Size(0, 0);
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdLayerWriteBitmapFile */
+int RdLayerWriteBitmapFile(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_POSITION position, const char* file_name)
+{
+    int ret;
+    RD_BITMAP bitmap;
+
+    ret = RdBitmapLoad(file_name, &bitmap);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    ret = Rd_LayerWriteRawPixels(rd_interface, layer_id, position, bitmap.size, bitmap.pixels);
+    RdBitmapFree(&bitmap);
+    return ret;
+}
@@ -0,0 +1,167 @@
+/* ripdraw-broadcast.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * broadcast interface: every frame is encoded once and written to all member interfaces
+ */
+#include "ripdraw.h"
+
+#define RD_PROTO_POS_SEQ			2
+
+int rd_extint_write(RD_INTERFACE* rd_interface, RD_BYTE* data_ptr, int data_len);
+int rd_cmd_response_receive_seq(RD_INTERFACE* rd_interface, int expected_cmd_id, RD_UWORD expected_seq_no);
+int rd_buffer_check_and_allocate(RD_INTERFACE_BUFFER* buffer, int required_capacity);
+int rd_interface_reserve(RD_INTERFACE* rd_interface);
+int rd_cmd_response_drain(RD_INTERFACE* rd_interface);
+int rd_broadcast_receive(RD_INTERFACE* rd_interface, int expected_cmd_id, RD_UWORD expected_seq_no);
+
+/* ================================================================== */
+/* RdBroadcastInit */
+RD_INTERFACE* RdBroadcastInit(RD_INTERFACE** members, int count)
+{
+    RD_INTERFACE* rd_interface;
+    RD_BROADCAST* broadcast;
+    int i;
+
+    if (members == NULL || count <= 0 || count > RD_BROADCAST_MAX_MEMBERS)
+    {
+        fprintf(stderr, "broadcast should have 1 to %d members\n", RD_BROADCAST_MAX_MEMBERS);
+        return NULL;
+    }
+    rd_interface = (RD_INTERFACE*) malloc(sizeof(RD_INTERFACE));
+    broadcast = (RD_BROADCAST*) malloc(sizeof(RD_BROADCAST));
+    if (!rd_interface || !broadcast)
+    {
+        RdFreeData(rd_interface);
+        RdFreeData(broadcast);
+        fprintf(stderr, "unable to allocate memory\n");
+        return NULL;
+    }
+    memset(rd_interface, 0, sizeof(RD_INTERFACE));
+    memset(broadcast, 0, sizeof(RD_BROADCAST));
+    for (i = 0; i < count; i++)
+    {
+        if (members[i] == NULL || members[i]->broadcast)
+        {
+            free(rd_interface);
+            free(broadcast);
+            fprintf(stderr, "invalid broadcast member %d\n", i);
+            return NULL;
+        }
+        broadcast->members[i].rd_interface = members[i];
+    }
+    broadcast->count = count;
+    rd_interface->broadcast = broadcast;
+    rd_interface->is_open = 1;
+    if (rd_interface_reserve(rd_interface) < 0)
+    {
+        RdInterfaceClose(rd_interface);
+        return NULL;
+    }
+    return rd_interface;
+}
+
+/* ================================================================== */
+/* write encoded request of broadcast interface to every member
+   only sequence number and checksum are patched for each member */
+int rd_broadcast_write(RD_INTERFACE* rd_interface)
+{
+    RD_BROADCAST* broadcast = rd_interface->broadcast;
+    RD_BROADCAST_MEMBER* member;
+    RD_BYTE* frame = rd_interface->request.ptr;
+    int size = rd_interface->request.size;
+    int ret = 0, tmp, i, slot;
+    RD_UWORD seq_no, checksum;
+
+    slot = (RD_UWORD) rd_interface->seq_no % RD_BROADCAST_SEQ_RING;
+    /* checksum without sequence number, the member sequence number is added back */
+    checksum = *((RD_UWORD*) (frame + size - 2)) - frame[RD_PROTO_POS_SEQ] - frame[RD_PROTO_POS_SEQ + 1];
+    for (i = 0; i < broadcast->count; i++)
+    {
+        member = &broadcast->members[i];
+        seq_no = (RD_UWORD) ++member->rd_interface->seq_no;
+        member->rd_interface->last_cmd_id = rd_interface->last_cmd_id;
+        /* member settings change behind its own cache */
+        RdStateCacheForget(member->rd_interface);
+        *((RD_UWORD*) (frame + RD_PROTO_POS_SEQ)) = seq_no;
+        *((RD_UWORD*) (frame + size - 2)) = checksum + (seq_no & 0xFF) + (seq_no >> 8);
+        tmp = rd_extint_write(member->rd_interface, frame, size);
+        member->seq_map[slot] = seq_no;
+        member->sent[slot] = (tmp >= 0);
+        if (tmp < 0)
+        {
+            member->result = tmp;
+            member->failed++;
+            if (ret == 0)
+            {
+                ret = tmp;
+            }
+        }
+    }
+    /* restore frame of broadcast interface */
+    *((RD_UWORD*) (frame + RD_PROTO_POS_SEQ)) = (RD_UWORD) rd_interface->seq_no;
+    *((RD_UWORD*) (frame + size - 2)) = checksum + frame[RD_PROTO_POS_SEQ] + frame[RD_PROTO_POS_SEQ + 1];
+    if (ret < 0)
+    {
+        /* members written answer this frame after the frames in flight, both are read so the next
+           command finds their streams in sync */
+        rd_cmd_response_drain(rd_interface);
+        rd_broadcast_receive(rd_interface, rd_interface->last_cmd_id, (RD_UWORD) rd_interface->seq_no);
+    }
+    return ret;
+}
+
+/* ================================================================== */
+/* receive response of every member, response of the first member is kept
+   returns the first error, but always reads the response of every member */
+int rd_broadcast_receive(RD_INTERFACE* rd_interface, int expected_cmd_id, RD_UWORD expected_seq_no)
+{
+    RD_BROADCAST* broadcast = rd_interface->broadcast;
+    RD_BROADCAST_MEMBER* member;
+    int ret = 0, tmp, i, slot, primary = -1;
+
+    slot = expected_seq_no % RD_BROADCAST_SEQ_RING;
+    for (i = 0; i < broadcast->count; i++)
+    {
+        member = &broadcast->members[i];
+        if (!member->sent[slot])
+        {
+            /* write failed, nothing to wait for */
+            continue;
+        }
+        member->sent[slot] = 0;
+        tmp = rd_cmd_response_receive_seq(member->rd_interface, expected_cmd_id, member->seq_map[slot]);
+        member->result = tmp;
+        if (tmp < 0)
+        {
+            member->failed++;
+            if (ret == 0)
+            {
+                ret = tmp;
+            }
+            continue;
+        }
+        if (primary < 0)
+        {
+            primary = i;
+        }
+    }
+    if (primary < 0)
+    {
+        return (ret < 0) ? ret : -0110201;
+    }
+
+    /* commands returning ids or data read them from the broadcast interface */
+    member = &broadcast->members[primary];
+    tmp = rd_buffer_check_and_allocate(&rd_interface->response, member->rd_interface->response.size);
+    if (tmp < 0)
+    {
+        return tmp;
+    }
+    memcpy(rd_interface->response.ptr, member->rd_interface->response.ptr, member->rd_interface->response.size);
+    rd_interface->response.size = member->rd_interface->response.size;
+    *((RD_UWORD*) (rd_interface->response.ptr + RD_PROTO_POS_SEQ)) = expected_seq_no;
+    rd_interface->last_response_status = member->rd_interface->last_response_status;
+    return ret;
+}
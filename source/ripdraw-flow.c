@@ -0,0 +1,79 @@
+/* ripdraw-flow.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * flow control: credits of requests in flight, so the device receive buffer never overruns
+ */
+#include "ripdraw.h"
+
+/* ================================================================== */
+/* RdFlowSetBudget */
+int RdFlowSetBudget(RD_INTERFACE* rd_interface, int budget)
+{
+    _RD_CHECK_INTERFACE();
+
+    if (budget < RD_FLOW_AUTO)
+    {
+        fprintf(stderr, "invalid flow budget: %d\n", budget);
+        return -0160101;
+    }
+    rd_interface->flow.discover = (budget == RD_FLOW_AUTO);
+    rd_interface->flow.budget = (budget == RD_FLOW_AUTO) ? RD_FLOW_AUTO_START : budget;
+    rd_interface->flow.acked_bytes = 0;
+    return 0;
+}
+
+/* ================================================================== */
+/* return credits of a request whose reply was read or lost */
+void rd_flow_release(RD_INTERFACE* rd_interface, const RD_INTERFACE_PENDING* sent, int result)
+{
+    RD_FLOW* flow = &rd_interface->flow;
+    int budget;
+
+    /* lost sync while other requests were in flight, the device most likely dropped bytes */
+    if (flow->discover && (result == -011602 || result == -011603) && flow->in_flight > 1 && flow->clean > 0)
+    {
+        budget = flow->in_flight_bytes / 2;
+        flow->budget = (budget < RD_FLOW_AUTO_MIN) ? RD_FLOW_AUTO_MIN : budget;
+        flow->acked_bytes = 0;
+        flow->clean = 0;
+        flow->overruns++;
+    }
+    else if (result == 0)
+    {
+        flow->clean++;
+        flow->acked_bytes += sent->size;
+        if (flow->discover && flow->acked_bytes >= flow->budget && flow->budget < RD_FLOW_AUTO_MAX)
+        {
+            flow->budget += RD_FLOW_AUTO_STEP;
+            flow->acked_bytes = 0;
+        }
+    }
+    if (flow->in_flight > 0)
+    {
+        flow->in_flight--;
+    }
+    flow->in_flight_bytes -= sent->size;
+    if (flow->in_flight_bytes < 0 || flow->in_flight == 0)
+    {
+        flow->in_flight_bytes = 0;
+    }
+}
+
+/* ================================================================== */
+/* RdFlowReport */
+void RdFlowReport(RD_INTERFACE* rd_interface, FILE* file)
+{
+    RD_FLOW* flow;
+
+    if (rd_interface == NULL)
+    {
+        return;
+    }
+    flow = &rd_interface->flow;
+    fprintf(file, "  budget %d bytes%s, %d in flight (%d bytes)\n", flow->budget,
+        flow->discover ? " discovered" : "", flow->in_flight, flow->in_flight_bytes);
+    fprintf(file, "  stalled %ld times for %lld us, %ld split commands blocked, %ld overruns\n",
+        flow->stalls, flow->stalled_us, flow->blocked, flow->overruns);
+}
@@ -0,0 +1,240 @@
+/* ripdraw-graph.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * host-side helpers for line and bar graphs
+ */
+#include "ripdraw.h"
+
+long long rd_extint_clock_us(void);
+
+/* ================================================================== */
+/* RdLineStreamInit */
+int RdLineStreamInit(RD_LINE_STREAM* stream, RD_ID graph_id, RD_COLOR color, RD_SIZE size,
+float min_value, float max_value, int samples_per_column, int frame_interval_ms, int capacity)
+{
+    if (stream == NULL)
+    {
+        fprintf(stderr, "stream should not NULL\n");
+        return -050101;
+    }
+    if (size.width == 0 || size.height == 0 || samples_per_column <= 0 || capacity <= 0 || max_value <= min_value)
+    {
+        fprintf(stderr, "invalid line stream parameter\n");
+        return -050102;
+    }
+    memset(stream, 0, sizeof(RD_LINE_STREAM));
+    stream->samples = (float*) malloc(capacity * sizeof(float));
+    /* two points per column at most */
+    stream->points = (RD_POSITION*) malloc(size.width * 2 * sizeof(RD_POSITION));
+    if (!stream->samples || !stream->points)
+    {
+        RdLineStreamFree(stream);
+        fprintf(stderr, "unable to allocate memory\n");
+        return -050103;
+    }
+    stream->graph_id = graph_id;
+    stream->color = color;
+    stream->size = size;
+    stream->min_value = min_value;
+    stream->max_value = max_value;
+    stream->samples_per_column = samples_per_column;
+    stream->frame_interval_ms = frame_interval_ms;
+    stream->capacity = capacity;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdLineStreamFree */
+int RdLineStreamFree(RD_LINE_STREAM* stream)
+{
+    if (stream)
+    {
+        RdFreeData(stream->samples);
+        RdFreeData(stream->points);
+        stream->samples = NULL;
+        stream->points = NULL;
+        stream->count = 0;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdLineStreamPush */
+void RdLineStreamPush(RD_LINE_STREAM* stream, float value)
+{
+    int tail;
+    if (stream->count == stream->capacity)
+    {
+        /* ring buffer full, oldest sample is dropped */
+        stream->head = (stream->head + 1) % stream->capacity;
+        stream->count--;
+        stream->dropped++;
+    }
+    tail = (stream->head + stream->count) % stream->capacity;
+    stream->samples[tail] = value;
+    stream->count++;
+}
+
+/* ================================================================== */
+/* RdLineStreamPushArray */
+void RdLineStreamPushArray(RD_LINE_STREAM* stream, const float* values, int count)
+{
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        RdLineStreamPush(stream, values[i]);
+    }
+}
+
+/* ================================================================== */
+/* map value to y pixel of the graph, larger values are drawn higher */
+static RD_UWORD rd_line_stream_y(const RD_LINE_STREAM* stream, float value)
+{
+    float y;
+    if (value <= stream->min_value)
+    {
+        return stream->size.height - 1;
+    }
+    if (value >= stream->max_value)
+    {
+        return 0;
+    }
+    y = (stream->max_value - value) * (stream->size.height - 1) / (stream->max_value - stream->min_value);
+    return (RD_UWORD) (y + 0.5f);
+}
+
+/* ================================================================== */
+/* RdLineStreamFlush */
+int RdLineStreamFlush(RD_INTERFACE* rd_interface, RD_LINE_STREAM* stream)
+{
+    int columns, column, i, point_count;
+    int min_index, max_index;
+    float value, min_value, max_value;
+
+    stream->last_flush_us = rd_extint_clock_us();
+    columns = stream->count / stream->samples_per_column;
+    /* columns older than one graph width would be overwritten anyway */
+    if (columns > stream->size.width)
+    {
+        int skip = (columns - stream->size.width) * stream->samples_per_column;
+        stream->head = (stream->head + skip) % stream->capacity;
+        stream->count -= skip;
+        stream->column = (stream->column + columns - stream->size.width) % stream->size.width;
+        columns = stream->size.width;
+    }
+    if (columns == 0)
+    {
+        return 0;
+    }
+
+    /* min/max decimation, extremes of each column are kept in the order they occurred */
+    point_count = 0;
+    for (column = 0; column < columns; column++)
+    {
+        min_index = max_index = 0;
+        min_value = max_value = stream->samples[stream->head];
+        for (i = 1; i < stream->samples_per_column; i++)
+        {
+            value = stream->samples[(stream->head + i) % stream->capacity];
+            if (value < min_value)
+            {
+                min_value = value;
+                min_index = i;
+            }
+            if (value > max_value)
+            {
+                max_value = value;
+                max_index = i;
+            }
+        }
+        stream->head = (stream->head + stream->samples_per_column) % stream->capacity;
+        stream->count -= stream->samples_per_column;
+
+        stream->points[point_count++] = Rd_Position(stream->column,
+            rd_line_stream_y(stream, (min_index <= max_index) ? min_value : max_value));
+        if (min_index != max_index)
+        {
+            stream->points[point_count++] = Rd_Position(stream->column,
+                rd_line_stream_y(stream, (min_index <= max_index) ? max_value : min_value));
+        }
+        stream->column = (stream->column + 1) % stream->size.width;
+    }
+    return Rd_LineGraphInsertPoints(rd_interface, stream->graph_id, stream->color, point_count, stream->points);
+}
+
+/* ================================================================== */
+/* RdLineStreamPoll */
+int RdLineStreamPoll(RD_INTERFACE* rd_interface, RD_LINE_STREAM* stream)
+{
+    if (rd_extint_clock_us() - stream->last_flush_us < (long long) stream->frame_interval_ms * 1000)
+    {
+        return 0;
+    }
+    return RdLineStreamFlush(rd_interface, stream);
+}
+
+/* ================================================================== */
+/* RdBarGraphInit */
+int RdBarGraphInit(RD_BAR_GRAPH* bar, RD_ID graph_id, RD_ID image_id, int stacks)
+{
+    if (bar == NULL)
+    {
+        fprintf(stderr, "bar graph should not NULL\n");
+        return -050201;
+    }
+    bar->graph_id = graph_id;
+    bar->image_id = image_id;
+    bar->stacks = stacks;
+    bar->target = stacks;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdBarGraphSet */
+void RdBarGraphSet(RD_BAR_GRAPH* bar, int stacks)
+{
+    bar->target = (stacks < 0) ? 0 : stacks;
+}
+
+/* ================================================================== */
+/* RdBarGraphFlush */
+int RdBarGraphFlush(RD_INTERFACE* rd_interface, RD_BAR_GRAPH* bar)
+{
+    int ret, count;
+
+    /* stack count of one command is a byte */
+    while (bar->target != bar->stacks)
+    {
+        if (bar->target > bar->stacks)
+        {
+            count = (bar->target - bar->stacks > 0xFF) ? 0xFF : bar->target - bar->stacks;
+            ret = Rd_BarGraphInsertStacks(rd_interface, bar->graph_id, (RD_BYTE) count, bar->image_id);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            bar->stacks += count;
+        }
+        else
+        {
+            count = (bar->stacks - bar->target > 0xFF) ? 0xFF : bar->stacks - bar->target;
+            ret = Rd_BarGraphRemoveStacks(rd_interface, bar->graph_id, (RD_BYTE) count);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            bar->stacks -= count;
+        }
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdBarGraphSetNow */
+int RdBarGraphSetNow(RD_INTERFACE* rd_interface, RD_BAR_GRAPH* bar, int stacks)
+{
+    RdBarGraphSet(bar, stacks);
+    return RdBarGraphFlush(rd_interface, bar);
+}
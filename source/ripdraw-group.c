@@ -0,0 +1,347 @@
+/* ripdraw-group.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * group of displays, every panel has its own worker thread
+ */
+#include "ripdraw.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#else
+#include <pthread.h>
+#endif
+
+/* state shared by the workers of a group */
+typedef struct _RD_GROUP_SYNC
+{
+#if defined(_WIN32) || defined(_WIN64)
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE changed;
+    HANDLE threads[RD_GROUP_MAX_PANELS];
+#else
+    pthread_mutex_t lock;
+    /* signalled when a job is submitted or finished and when the group closes */
+    pthread_cond_t changed;
+    pthread_t threads[RD_GROUP_MAX_PANELS];
+#endif
+    int started;
+    int stop;
+} RD_GROUP_SYNC;
+
+/* ================================================================== */
+/* lock and condition of a group */
+static void rd_group_sync_init(RD_GROUP_SYNC* sync)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    InitializeCriticalSection(&sync->lock);
+    InitializeConditionVariable(&sync->changed);
+#else
+    pthread_mutex_init(&sync->lock, NULL);
+    pthread_cond_init(&sync->changed, NULL);
+#endif
+}
+
+static void rd_group_sync_destroy(RD_GROUP_SYNC* sync)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    DeleteCriticalSection(&sync->lock);
+#else
+    pthread_mutex_destroy(&sync->lock);
+    pthread_cond_destroy(&sync->changed);
+#endif
+}
+
+static void rd_group_lock(RD_GROUP_SYNC* sync)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    EnterCriticalSection(&sync->lock);
+#else
+    pthread_mutex_lock(&sync->lock);
+#endif
+}
+
+static void rd_group_unlock(RD_GROUP_SYNC* sync)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    LeaveCriticalSection(&sync->lock);
+#else
+    pthread_mutex_unlock(&sync->lock);
+#endif
+}
+
+static void rd_group_wait(RD_GROUP_SYNC* sync)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    SleepConditionVariableCS(&sync->changed, &sync->lock, INFINITE);
+#else
+    pthread_cond_wait(&sync->changed, &sync->lock);
+#endif
+}
+
+static void rd_group_wake(RD_GROUP_SYNC* sync)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    WakeAllConditionVariable(&sync->changed);
+#else
+    pthread_cond_broadcast(&sync->changed);
+#endif
+}
+
+static void rd_group_worker(RD_PANEL* panel);
+
+/* ================================================================== */
+/* thread entry of a panel worker */
+#if defined(_WIN32) || defined(_WIN64)
+static DWORD WINAPI rd_group_thread(LPVOID arg)
+{
+    rd_group_worker((RD_PANEL*) arg);
+    return 0;
+}
+#else
+static void* rd_group_thread(void* arg)
+{
+    rd_group_worker((RD_PANEL*) arg);
+    return NULL;
+}
+#endif
+
+/* ================================================================== */
+/* start worker of a panel, 0 on success */
+static int rd_group_thread_start(RD_GROUP_SYNC* sync, RD_PANEL* panel)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    sync->threads[panel->index] = CreateThread(NULL, 0, rd_group_thread, panel, 0, NULL);
+    return (sync->threads[panel->index] == NULL) ? -1 : 0;
+#else
+    return pthread_create(&sync->threads[panel->index], NULL, rd_group_thread, panel);
+#endif
+}
+
+/* ================================================================== */
+/* wait until worker of a panel has stopped */
+static void rd_group_thread_join(RD_GROUP_SYNC* sync, int index)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    WaitForSingleObject(sync->threads[index], INFINITE);
+    CloseHandle(sync->threads[index]);
+#else
+    pthread_join(sync->threads[index], NULL);
+#endif
+}
+
+/* ================================================================== */
+/* worker thread: run jobs of one panel until the group closes */
+static void rd_group_worker(RD_PANEL* panel)
+{
+
+    RD_DISPLAY_GROUP* group = panel->group;
+    RD_GROUP_SYNC* sync = (RD_GROUP_SYNC*) group->sync;
+    RD_PANEL_JOB job;
+    void* context;
+    int ret;
+
+    rd_group_lock(sync);
+    for (;;)
+    {
+        while (!sync->stop && panel->job == NULL)
+        {
+            rd_group_wait(sync);
+        }
+        if (panel->job == NULL)
+        {
+            break;
+        }
+        job = panel->job;
+        context = panel->context;
+        rd_group_unlock(sync);
+
+        /* the interface is only used by this thread while the job runs */
+        ret = job(panel->rd_interface, panel->index, context);
+
+        rd_group_lock(sync);
+        panel->result = ret;
+        panel->job = NULL;
+        group->running--;
+        if (ret < 0)
+        {
+            group->failed++;
+        }
+        rd_group_wake(sync);
+    }
+    rd_group_unlock(sync);
+}
+
+/* ================================================================== */
+/* RdDisplayGroupOpen */
+int RdDisplayGroupOpen(RD_DISPLAY_GROUP* group, const char** port_names, int count)
+{
+    RD_GROUP_SYNC* sync;
+    int i;
+
+    if (group == NULL || port_names == NULL)
+    {
+        fprintf(stderr, "display group should not NULL\n");
+        return -0100101;
+    }
+    if (count <= 0 || count > RD_GROUP_MAX_PANELS)
+    {
+        fprintf(stderr, "display group should have 1 to %d panels\n", RD_GROUP_MAX_PANELS);
+        return -0100102;
+    }
+    memset(group, 0, sizeof(RD_DISPLAY_GROUP));
+    sync = (RD_GROUP_SYNC*) malloc(sizeof(RD_GROUP_SYNC));
+    if (!sync)
+    {
+        fprintf(stderr, "unable to allocate memory\n");
+        return -0100103;
+    }
+    memset(sync, 0, sizeof(RD_GROUP_SYNC));
+    rd_group_sync_init(sync);
+    group->sync = sync;
+
+    for (i = 0; i < count; i++)
+    {
+        group->panels[i].index = i;
+        group->panels[i].group = group;
+        group->panels[i].rd_interface = RdInterfaceInit(port_names[i]);
+        group->count++;
+        if (group->panels[i].rd_interface == NULL)
+        {
+            fprintf(stderr, "unable to open panel %d on %s\n", i, port_names[i]);
+            RdDisplayGroupClose(group);
+            return -0100104;
+        }
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (rd_group_thread_start(sync, &group->panels[i]) != 0)
+        {
+            fprintf(stderr, "unable to start worker of panel %d\n", i);
+            RdDisplayGroupClose(group);
+            return -0100105;
+        }
+        sync->started++;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdDisplayGroupClose */
+int RdDisplayGroupClose(RD_DISPLAY_GROUP* group)
+{
+    RD_GROUP_SYNC* sync;
+    int i;
+
+    if (group == NULL || group->sync == NULL)
+    {
+        fprintf(stderr, "display group should not NULL\n");
+        return -0100201;
+    }
+    sync = (RD_GROUP_SYNC*) group->sync;
+    /* submitted jobs are finished before the workers stop */
+    rd_group_lock(sync);
+    sync->stop = 1;
+    rd_group_wake(sync);
+    rd_group_unlock(sync);
+    for (i = 0; i < sync->started; i++)
+    {
+        rd_group_thread_join(sync, i);
+    }
+    for (i = 0; i < group->count; i++)
+    {
+        if (group->panels[i].rd_interface)
+        {
+            RdInterfaceClose(group->panels[i].rd_interface);
+        }
+    }
+    rd_group_sync_destroy(sync);
+    free(sync);
+    memset(group, 0, sizeof(RD_DISPLAY_GROUP));
+    return 0;
+}
+
+/* ================================================================== */
+/* RdDisplayGroupSubmit */
+int RdDisplayGroupSubmit(RD_DISPLAY_GROUP* group, int panel, RD_PANEL_JOB job, void* context)
+{
+    RD_GROUP_SYNC* sync;
+
+    if (group == NULL || group->sync == NULL || job == NULL)
+    {
+        fprintf(stderr, "display group should not NULL\n");
+        return -0100301;
+    }
+    if (panel < 0 || panel >= group->count)
+    {
+        fprintf(stderr, "invalid panel %d\n", panel);
+        return -0100302;
+    }
+    sync = (RD_GROUP_SYNC*) group->sync;
+    rd_group_lock(sync);
+    /* one job per panel, wait for the previous one */
+    while (group->panels[panel].job != NULL)
+    {
+        rd_group_wait(sync);
+    }
+    group->panels[panel].job = job;
+    group->panels[panel].context = context;
+    group->panels[panel].result = 0;
+    group->running++;
+    rd_group_wake(sync);
+    rd_group_unlock(sync);
+    return 0;
+}
+
+/* ================================================================== */
+/* RdDisplayGroupRun */
+int RdDisplayGroupRun(RD_DISPLAY_GROUP* group, RD_PANEL_JOB job, void* context)
+{
+    int ret, i;
+
+    if (group == NULL)
+    {
+        fprintf(stderr, "display group should not NULL\n");
+        return -0100401;
+    }
+    for (i = 0; i < group->count; i++)
+    {
+        ret = RdDisplayGroupSubmit(group, i, job, context);
+        if (ret < 0)
+        {
+            return ret;
+        }
+    }
+    return RdDisplayGroupWait(group);
+}
+
+/* ================================================================== */
+/* RdDisplayGroupWait */
+int RdDisplayGroupWait(RD_DISPLAY_GROUP* group)
+{
+    RD_GROUP_SYNC* sync;
+    int i;
+
+    if (group == NULL || group->sync == NULL)
+    {
+        fprintf(stderr, "display group should not NULL\n");
+        return -0100501;
+    }
+    sync = (RD_GROUP_SYNC*) group->sync;
+    rd_group_lock(sync);
+    while (group->running > 0)
+    {
+        rd_group_wait(sync);
+    }
+    rd_group_unlock(sync);
+
+    /* error of the first failed panel, all results stay in the panels */
+    for (i = 0; i < group->count; i++)
+    {
+        if (group->panels[i].result < 0)
+        {
+            return group->panels[i].result;
+        }
+    }
+    return 0;
+}
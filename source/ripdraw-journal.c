@@ -0,0 +1,320 @@
+/* ripdraw-journal.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * journal of the live device state, replayed after a reconnect
+ */
+#include "ripdraw.h"
+
+#define RD_PROTO_POS_BYTE_0			6
+#define RD_PROTO_POS_BYTE_1			8
+
+int rd_extint_open(RD_INTERFACE* rd_interface, const char* port_name);
+int rd_extint_close(RD_INTERFACE* rd_interface);
+int rd_cmd_request_init(RD_INTERFACE* rd_interface, RD_COMMAND_IDS cmd_id);
+int rd_buffer_check_and_allocate(RD_INTERFACE_BUFFER* buffer, int required_capacity);
+int rd_cmd_request_process(RD_INTERFACE* rd_interface);
+int rd_cmd_response_receive(RD_INTERFACE* rd_interface);
+int rd_cmd_response_check_and_get_uword(RD_INTERFACE* rd_interface, int byte_position, RD_UWORD* output);
+RD_RESOURCE* rd_resource_find(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+RD_ID rd_resource_device_id(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+void rd_prefetch_forget(RD_INTERFACE* rd_interface);
+
+/* ================================================================== */
+/* append request just answered by the device */
+static int rd_journal_append(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id, int update)
+{
+    RD_JOURNAL* journal = rd_interface->journal;
+    RD_JOURNAL_ENTRY* entry;
+    RD_BYTE* payload;
+    int length, i;
+
+    if (journal == NULL || rd_interface->replaying)
+    {
+        return 0;
+    }
+
+    /* payload without checksum, resource ids are stored as client ids */
+    length = rd_interface->request.size - RD_PROTO_POS_BYTE_0 - 2;
+    payload = (RD_BYTE*) malloc(length + 1);
+    if (!payload)
+    {
+        fprintf(stderr, "unable to allocate memory\n");
+        return -0130101;
+    }
+    memcpy(payload, rd_interface->request.ptr + RD_PROTO_POS_BYTE_0, length);
+    for (i = 0; i < rd_interface->request_id_count; i++)
+    {
+        *((RD_UWORD*) (payload + rd_interface->request_ids[i].offset)) = rd_interface->request_ids[i].id;
+    }
+
+    /* an update replaces the previous one of the same command and target,
+       it moves to the end to stay behind the commands sent in between */
+    if (update)
+    {
+        for (i = 0; i < journal->count; i++)
+        {
+            entry = &journal->entries[i];
+            if (entry->update && entry->type == type && entry->id == id && entry->cmd_id == rd_interface->last_cmd_id)
+            {
+                free(entry->payload);
+                journal->count--;
+                memmove(entry, entry + 1, (journal->count - i) * sizeof(RD_JOURNAL_ENTRY));
+                break;
+            }
+        }
+    }
+    if (journal->count == journal->capacity)
+    {
+        int capacity = journal->capacity ? journal->capacity * 2 : 64;
+        RD_JOURNAL_ENTRY* tmp = (RD_JOURNAL_ENTRY*) realloc(journal->entries, capacity * sizeof(RD_JOURNAL_ENTRY));
+        if (!tmp)
+        {
+            free(payload);
+            fprintf(stderr, "unable to allocate memory\n");
+            return -0130101;
+        }
+        journal->entries = tmp;
+        journal->capacity = capacity;
+    }
+    entry = &journal->entries[journal->count++];
+    entry->cmd_id = rd_interface->last_cmd_id;
+    entry->type = type;
+    entry->id = id;
+    entry->update = update;
+    entry->id_count = rd_interface->request_id_count;
+    memcpy(entry->ids, rd_interface->request_ids, sizeof(entry->ids));
+    entry->length = length;
+    entry->payload = payload;
+    return 0;
+}
+
+/* ================================================================== */
+/* record request creating a resource */
+int rd_journal_record(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id)
+{
+    return rd_journal_append(rd_interface, type, id, 0);
+}
+
+/* ================================================================== */
+/* record request changing a live resource, or a layer or page setting with type RD_RESOURCE_ALL */
+int rd_journal_update(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id)
+{
+    return rd_journal_append(rd_interface, type, id, 1);
+}
+
+/* ================================================================== */
+/* remove entries of a released resource, its creation and its updates */
+void rd_journal_remove(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id)
+{
+    RD_JOURNAL* journal = rd_interface->journal;
+    int i, count = 0;
+
+    if (journal == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < journal->count; i++)
+    {
+        if (journal->entries[i].type == type && journal->entries[i].id == id)
+        {
+            free(journal->entries[i].payload);
+        }
+        else
+        {
+            journal->entries[count++] = journal->entries[i];
+        }
+    }
+    journal->count = count;
+}
+
+/* ================================================================== */
+/* remove entries of a resource type, RD_RESOURCE_ALL removes everything */
+void rd_journal_forget(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type)
+{
+    RD_JOURNAL* journal = rd_interface->journal;
+    int i, count = 0;
+
+    if (journal == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < journal->count; i++)
+    {
+        if (type != RD_RESOURCE_ALL && journal->entries[i].type != type)
+        {
+            journal->entries[count++] = journal->entries[i];
+        }
+        else
+        {
+            free(journal->entries[i].payload);
+        }
+    }
+    journal->count = count;
+}
+
+/* ================================================================== */
+/* RdJournalEnable */
+int RdJournalEnable(RD_INTERFACE* rd_interface, int enable)
+{
+    _RD_CHECK_INTERFACE();
+
+    if (enable && rd_interface->journal == NULL)
+    {
+#ifdef RD_NO_HEAP
+        fprintf(stderr, "journal needs heap memory\n");
+        return -0130402;
+#endif
+        rd_interface->journal = (RD_JOURNAL*) malloc(sizeof(RD_JOURNAL));
+        if (!rd_interface->journal)
+        {
+            fprintf(stderr, "unable to allocate memory\n");
+            return -0130401;
+        }
+        memset(rd_interface->journal, 0, sizeof(RD_JOURNAL));
+    }
+    else if (!enable && rd_interface->journal)
+    {
+        rd_journal_forget(rd_interface, RD_RESOURCE_ALL);
+        RdFreeData(rd_interface->journal->entries);
+        free(rd_interface->journal);
+        rd_interface->journal = NULL;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* send one journal entry again */
+static int rd_journal_replay_entry(RD_INTERFACE* rd_interface, RD_JOURNAL_ENTRY* entry)
+{
+    int ret, i;
+    RD_ID device_id;
+    RD_RESOURCE* resource;
+
+    ret = rd_cmd_request_init(rd_interface, (RD_COMMAND_IDS) entry->cmd_id);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    ret = rd_buffer_check_and_allocate(&rd_interface->request, rd_interface->request.size + entry->length);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    memcpy(rd_interface->request.ptr + rd_interface->request.size, entry->payload, entry->length);
+    rd_interface->request.size += entry->length;
+    for (i = 0; i < entry->id_count; i++)
+    {
+        *((RD_UWORD*) (rd_interface->request.ptr + RD_PROTO_POS_BYTE_0 + entry->ids[i].offset)) =
+            rd_resource_device_id(rd_interface, entry->ids[i].type, entry->ids[i].id);
+    }
+    ret = rd_cmd_request_process(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (entry->update)
+    {
+        return 0;
+    }
+    /* the device may hand out a different id this time */
+    ret = rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, &device_id);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    resource = rd_resource_find(rd_interface, entry->type, entry->id);
+    if (resource)
+    {
+        resource->device_id = device_id;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdJournalReplay */
+int RdJournalReplay(RD_INTERFACE* rd_interface)
+{
+    int ret, tmp, i, pass;
+    RD_JOURNAL* journal;
+    _RD_CHECK_INTERFACE();
+
+    journal = rd_interface->journal;
+    if (journal == NULL)
+    {
+        fprintf(stderr, "journal not enabled\n");
+        return -0130601;
+    }
+    rd_interface->replaying = 1;
+    ret = Rd_Reset(rd_interface);
+    /* composes last, they show what the other entries restored */
+    for (pass = 0; pass < 2 && ret == 0; pass++)
+    {
+        for (i = 0; i < journal->count; i++)
+        {
+            if ((journal->entries[i].cmd_id == Cmd_ComposeLayersToPage) != pass)
+            {
+                continue;
+            }
+            /* restore as much as possible, first error is returned */
+            tmp = rd_journal_replay_entry(rd_interface, &journal->entries[i]);
+            if (tmp < 0 && ret == 0)
+            {
+                ret = tmp;
+            }
+        }
+    }
+    rd_interface->remapped = 0;
+    for (i = 0; i < rd_interface->resource_count; i++)
+    {
+        if (rd_interface->resources[i].device_id != rd_interface->resources[i].id)
+        {
+            rd_interface->remapped = 1;
+        }
+    }
+    rd_interface->replaying = 0;
+    return ret;
+}
+
+/* ================================================================== */
+/* RdInterfaceReconnect */
+int RdInterfaceReconnect(RD_INTERFACE* rd_interface, const char* port_name)
+{
+    int ret;
+
+    if (rd_interface == NULL || rd_interface->broadcast)
+    {
+        fprintf(stderr, "reconnect needs a serial interface\n");
+        return -0130701;
+    }
+    if (rd_interface->is_open)
+    {
+        rd_extint_close(rd_interface);
+    }
+    ret = rd_extint_open(rd_interface, port_name);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_interface->is_open = 1;
+    /* replies of the old link never arrive */
+    rd_interface->pending_count = 0;
+    rd_interface->flow.in_flight = 0;
+    rd_interface->flow.in_flight_bytes = 0;
+    rd_interface->tx.buffer.size = 0;
+    rd_interface->tx.frames = 0;
+    rd_prefetch_forget(rd_interface);
+    /* the device may have rebooted */
+    RdStateCacheForget(rd_interface);
+    if (rd_interface->journal == NULL)
+    {
+        return 0;
+    }
+    return RdJournalReplay(rd_interface);
+}
@@ -0,0 +1,339 @@
+/* ripdraw-pack.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * packed asset file: header, pixel blobs at aligned offsets, index sorted by label
+ */
+#include "ripdraw.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* ================================================================== */
+/* FNV-1a hash of pixel data */
+unsigned int RdPackHash(const RD_BYTE* data, int length)
+{
+    unsigned int hash = 2166136261u;
+    int i;
+    for (i = 0; i < length; i++)
+    {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/* ================================================================== */
+/* compare entries by label */
+static int rd_pack_entry_compare(const void* a, const void* b)
+{
+    return strcmp(((const RD_PACK_ENTRY*) a)->label, ((const RD_PACK_ENTRY*) b)->label);
+}
+
+/* ================================================================== */
+/* RdPackWriterOpen */
+int RdPackWriterOpen(RD_PACK_WRITER* writer, const char* file_name)
+{
+    RD_PACK_HEADER header;
+
+    if (writer == NULL)
+    {
+        fprintf(stderr, "writer should not NULL\n");
+        return -040101;
+    }
+    memset(writer, 0, sizeof(RD_PACK_WRITER));
+    writer->file = fopen(file_name, "wb");
+    if (!writer->file)
+    {
+        fprintf(stderr, "unable to create %s\n", file_name);
+        return -040102;
+    }
+    /* header is written again with the index offset on close */
+    memset(&header, 0, sizeof(header));
+    if (fwrite(&header, sizeof(header), 1, writer->file) != 1)
+    {
+        fclose(writer->file);
+        writer->file = NULL;
+        fprintf(stderr, "unable to write %s\n", file_name);
+        return -040103;
+    }
+    writer->offset = sizeof(header);
+    return 0;
+}
+
+/* ================================================================== */
+/* RdPackWriterAdd */
+int RdPackWriterAdd(RD_PACK_WRITER* writer, const char* label, const RD_BITMAP* bitmap, RD_POSITION origin)
+{
+    if (bitmap == NULL)
+    {
+        fprintf(stderr, "bitmap should not NULL\n");
+        return -040201;
+    }
+    return RdPackWriterAddHashed(writer, label, bitmap, origin,
+        RdPackHash((const RD_BYTE*) bitmap->pixels, bitmap->size.width * bitmap->size.height * sizeof(RD_COLOR)));
+}
+
+/* ================================================================== */
+/* RdPackWriterAddHashed */
+int RdPackWriterAddHashed(RD_PACK_WRITER* writer, const char* label, const RD_BITMAP* bitmap, RD_POSITION origin,
+unsigned int hash)
+{
+    static const RD_BYTE padding[RD_PACK_ALIGN] = { 0 };
+    RD_PACK_ENTRY* entry;
+    unsigned int length, pad;
+
+    if (writer == NULL || writer->file == NULL || bitmap == NULL)
+    {
+        fprintf(stderr, "writer should not NULL\n");
+        return -040201;
+    }
+    if (strlen(label) >= RD_PACK_LABEL_LENGTH)
+    {
+        fprintf(stderr, "label too long: %s\n", label);
+        return -040202;
+    }
+    if (writer->count == writer->capacity)
+    {
+        int capacity = writer->capacity ? writer->capacity * 2 : 32;
+        RD_PACK_ENTRY* tmp = (RD_PACK_ENTRY*) realloc(writer->entries, capacity * sizeof(RD_PACK_ENTRY));
+        if (!tmp)
+        {
+            fprintf(stderr, "unable to allocate memory\n");
+            return -040203;
+        }
+        writer->entries = tmp;
+        writer->capacity = capacity;
+    }
+
+    /* every blob starts at an aligned offset so it can be used in place */
+    pad = (RD_PACK_ALIGN - writer->offset % RD_PACK_ALIGN) % RD_PACK_ALIGN;
+    length = bitmap->size.width * bitmap->size.height * sizeof(RD_COLOR);
+    if ((pad && fwrite(padding, pad, 1, writer->file) != 1)
+        || (length && fwrite(bitmap->pixels, length, 1, writer->file) != 1))
+    {
+        fprintf(stderr, "unable to write pack\n");
+        return -040204;
+    }
+
+    entry = &writer->entries[writer->count++];
+    memset(entry, 0, sizeof(RD_PACK_ENTRY));
+    strcpy(entry->label, label);
+    entry->width = bitmap->size.width;
+    entry->height = bitmap->size.height;
+    entry->origin_x = origin.x;
+    entry->origin_y = origin.y;
+    entry->offset = writer->offset + pad;
+    entry->length = length;
+    entry->hash = hash;
+    writer->offset = entry->offset + length;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdPackWriterClose */
+int RdPackWriterClose(RD_PACK_WRITER* writer)
+{
+    int ret = 0, i;
+    RD_PACK_HEADER header;
+
+    if (writer == NULL || writer->file == NULL)
+    {
+        fprintf(stderr, "writer should not NULL\n");
+        return -040301;
+    }
+    qsort(writer->entries, writer->count, sizeof(RD_PACK_ENTRY), rd_pack_entry_compare);
+    for (i = 1; i < writer->count; i++)
+    {
+        if (strcmp(writer->entries[i - 1].label, writer->entries[i].label) == 0)
+        {
+            fprintf(stderr, "duplicate label: %s\n", writer->entries[i].label);
+            ret = -040302;
+        }
+    }
+
+    memcpy(header.magic, RD_PACK_MAGIC, 4);
+    header.version = RD_PACK_VERSION;
+    header.entry_count = writer->count;
+    header.index_offset = writer->offset;
+    if ((writer->count && fwrite(writer->entries, sizeof(RD_PACK_ENTRY), writer->count, writer->file) != (size_t) writer->count)
+        || fseek(writer->file, 0, SEEK_SET) != 0
+        || fwrite(&header, sizeof(header), 1, writer->file) != 1)
+    {
+        fprintf(stderr, "unable to write pack\n");
+        ret = -040303;
+    }
+    if (fclose(writer->file) != 0 && ret == 0)
+    {
+        fprintf(stderr, "unable to write pack\n");
+        ret = -040303;
+    }
+    free(writer->entries);
+    memset(writer, 0, sizeof(RD_PACK_WRITER));
+    return ret;
+}
+
+/* ================================================================== */
+/* RdPackOpen */
+int RdPackOpen(const char* file_name, RD_PACK* pack)
+{
+    const RD_PACK_HEADER* header;
+    unsigned int length;
+
+    if (pack == NULL)
+    {
+        fprintf(stderr, "pack should not NULL\n");
+        return -040401;
+    }
+    memset(pack, 0, sizeof(RD_PACK));
+#if defined(_WIN32) || defined(_WIN64)
+    {
+        HANDLE file, mapping;
+        file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            fprintf(stderr, "unable to open %s\n", file_name);
+            return -040402;
+        }
+        length = GetFileSize(file, NULL);
+        mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(file);
+        pack->data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+        if (!pack->data)
+        {
+            fprintf(stderr, "unable to map %s\n", file_name);
+            return -040403;
+        }
+    }
+#else
+    {
+        int handle;
+        struct stat info;
+        handle = open(file_name, O_RDONLY);
+        if (handle < 0)
+        {
+            fprintf(stderr, "unable to open %s\n", file_name);
+            return -040402;
+        }
+        if (fstat(handle, &info) < 0 || info.st_size == 0)
+        {
+            close(handle);
+            fprintf(stderr, "unable to map %s\n", file_name);
+            return -040403;
+        }
+        length = (unsigned int) info.st_size;
+        pack->data = mmap(NULL, length, PROT_READ, MAP_SHARED, handle, 0);
+        close(handle);
+        if (pack->data == MAP_FAILED)
+        {
+            pack->data = NULL;
+            fprintf(stderr, "unable to map %s\n", file_name);
+            return -040403;
+        }
+    }
+#endif
+    pack->length = length;
+
+    /* validate header and index, entries are used in place */
+    header = (const RD_PACK_HEADER*) pack->data;
+    if (length < sizeof(RD_PACK_HEADER) || memcmp(header->magic, RD_PACK_MAGIC, 4) != 0
+        || header->version != RD_PACK_VERSION || header->index_offset > length
+        || (length - header->index_offset) / sizeof(RD_PACK_ENTRY) < header->entry_count)
+    {
+        RdPackClose(pack);
+        fprintf(stderr, "invalid pack %s\n", file_name);
+        return -040404;
+    }
+    pack->entries = (const RD_PACK_ENTRY*) ((const RD_BYTE*) pack->data + header->index_offset);
+    pack->count = header->entry_count;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdPackClose */
+int RdPackClose(RD_PACK* pack)
+{
+    if (pack && pack->data)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        UnmapViewOfFile(pack->data);
+#else
+        munmap(pack->data, pack->length);
+#endif
+    }
+    if (pack)
+    {
+        memset(pack, 0, sizeof(RD_PACK));
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdPackFind */
+const RD_PACK_ENTRY* RdPackFind(const RD_PACK* pack, const char* label)
+{
+    int low = 0, high, middle, cmp;
+    const RD_PACK_ENTRY* entry;
+
+    if (pack == NULL || pack->entries == NULL)
+    {
+        return NULL;
+    }
+    high = pack->count - 1;
+    while (low <= high)
+    {
+        middle = (low + high) / 2;
+        cmp = strncmp(label, pack->entries[middle].label, RD_PACK_LABEL_LENGTH);
+        if (cmp == 0)
+        {
+            entry = &pack->entries[middle];
+            /* blob must lie inside the mapping */
+            if (entry->offset > pack->length || pack->length - entry->offset < entry->length
+                || entry->length != (unsigned int) entry->width * entry->height * sizeof(RD_COLOR))
+            {
+                fprintf(stderr, "invalid pack entry %s\n", label);
+                return NULL;
+            }
+            return entry;
+        }
+        if (cmp < 0)
+        {
+            high = middle - 1;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+    return NULL;
+}
+
+/* ================================================================== */
+/* RdPackPixels */
+const RD_COLOR* RdPackPixels(const RD_PACK* pack, const RD_PACK_ENTRY* entry)
+{
+    return (const RD_COLOR*) ((const RD_BYTE*) pack->data + entry->offset);
+}
+
+/* ================================================================== */
+/* RdLayerWritePackImage */
+int RdLayerWritePackImage(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_POSITION position,
+const RD_PACK* pack, const char* label)
+{
+    const RD_PACK_ENTRY* entry = RdPackFind(pack, label);
+    if (!entry)
+    {
+        fprintf(stderr, "image %s not in pack\n", label);
+        return -040501;
+    }
+    return Rd_LayerWriteRawPixels(rd_interface, layer_id,
+        Rd_Position(position.x + entry->origin_x, position.y + entry->origin_y),
+        Rd_Size(entry->width, entry->height), RdPackPixels(pack, entry));
+}
@@ -0,0 +1,324 @@
+/* ripdraw-prefetch.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * prefetch: images of upcoming screens loaded while the link is idle
+ */
+#include "ripdraw.h"
+
+RD_RESOURCE* rd_resource_find(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+
+/* ================================================================== */
+/* entry of a load, NULL when it was never declared */
+static RD_PREFETCH_ENTRY* rd_prefetch_find(RD_PREFETCH* prefetch, RD_RESOURCE_TYPE type, const char* label,
+    RD_UWORD index_start, RD_UWORD index_step, RD_UWORD index_count)
+{
+    int i;
+    RD_PREFETCH_ENTRY* entry;
+
+    for (i = 0; i < prefetch->count; i++)
+    {
+        entry = &prefetch->entries[i];
+        if (entry->type == type && strcmp(entry->label, label) == 0 && entry->index_start == index_start
+            && entry->index_step == index_step && entry->index_count == index_count)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* ================================================================== */
+/* entry of a load, added when it is new */
+static int rd_prefetch_entry(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, const char* label,
+    RD_UWORD index_start, RD_UWORD index_step, RD_UWORD index_count, RD_PREFETCH_ENTRY** entry)
+{
+    RD_PREFETCH* prefetch;
+    _RD_CHECK_INTERFACE();
+
+#ifdef RD_NO_HEAP
+    fprintf(stderr, "prefetch needs heap memory\n");
+    return -0210103;
+#endif
+    if (label == NULL || strlen(label) >= RD_PREFETCH_LABEL_LENGTH)
+    {
+        fprintf(stderr, "invalid prefetch label\n");
+        return -0210102;
+    }
+    if (rd_interface->prefetch == NULL)
+    {
+        rd_interface->prefetch = (RD_PREFETCH*) malloc(sizeof(RD_PREFETCH));
+        if (!rd_interface->prefetch)
+        {
+            fprintf(stderr, "unable to allocate memory\n");
+            return -0210101;
+        }
+        memset(rd_interface->prefetch, 0, sizeof(RD_PREFETCH));
+    }
+    prefetch = rd_interface->prefetch;
+    *entry = rd_prefetch_find(prefetch, type, label, index_start, index_step, index_count);
+    if (*entry)
+    {
+        return 0;
+    }
+    if (prefetch->count == prefetch->capacity)
+    {
+        int capacity = prefetch->capacity ? prefetch->capacity * 2 : 32;
+        RD_PREFETCH_ENTRY* tmp = (RD_PREFETCH_ENTRY*) realloc(prefetch->entries, capacity * sizeof(RD_PREFETCH_ENTRY));
+        if (!tmp)
+        {
+            fprintf(stderr, "unable to allocate memory\n");
+            return -0210101;
+        }
+        prefetch->entries = tmp;
+        prefetch->capacity = capacity;
+    }
+    *entry = &prefetch->entries[prefetch->count++];
+    memset(*entry, 0, sizeof(RD_PREFETCH_ENTRY));
+    (*entry)->type = type;
+    strcpy((*entry)->label, label);
+    (*entry)->index_start = index_start;
+    (*entry)->index_step = index_step;
+    (*entry)->index_count = index_count;
+    (*entry)->state = RD_PREFETCH_DECLARED;
+    return 0;
+}
+
+/* ================================================================== */
+/* 1 when the id of an entry is still on the device, a reset or release forgets it */
+static int rd_prefetch_ready(RD_INTERFACE* rd_interface, const RD_PREFETCH_ENTRY* entry)
+{
+    return entry->state == RD_PREFETCH_READY && rd_resource_find(rd_interface, entry->type, entry->id) != NULL;
+}
+
+/* ================================================================== */
+/* load of an entry in the current phase */
+static int rd_prefetch_load(RD_INTERFACE* rd_interface, RD_PREFETCH_ENTRY* entry)
+{
+    if (entry->type == RD_RESOURCE_IMAGE_LIST)
+    {
+        return Rd_ImageListLoad(rd_interface, entry->label, entry->index_start, entry->index_step,
+            entry->index_count, &entry->id);
+    }
+    return Rd_ImageLoad(rd_interface, entry->label, &entry->id);
+}
+
+/* ================================================================== */
+/* load of an entry sent or completed by the window */
+static int rd_prefetch_send(RD_INTERFACE* rd_interface, void* context, int i)
+{
+    return rd_prefetch_load(rd_interface, &((RD_PREFETCH*) context)->entries[i]);
+}
+
+/* ================================================================== */
+/* keep the id of a completed load, failed loads are loaded again when their id is asked for */
+static void rd_prefetch_done(RD_INTERFACE* rd_interface, void* context, int i, int result)
+{
+    RD_PREFETCH* prefetch = (RD_PREFETCH*) context;
+    RD_PREFETCH_ENTRY* entry = &prefetch->entries[i];
+
+    (void) rd_interface;
+    entry->state = (result == 0) ? RD_PREFETCH_READY : RD_PREFETCH_FAILED;
+    entry->error = result;
+    if (result == 0)
+    {
+        prefetch->loaded++;
+    }
+}
+
+/* ================================================================== */
+/* take replies of the loads in flight, before any other reply is read */
+void rd_prefetch_complete(RD_INTERFACE* rd_interface)
+{
+    RD_PREFETCH* prefetch = rd_interface->prefetch;
+    RD_ASYNC_PHASE phase;
+    RD_INTERFACE_PENDING ticket;
+
+    if (prefetch == NULL || prefetch->window.count == 0 || prefetch->busy)
+    {
+        return;
+    }
+    /* called when a split command is encoded, its phase is restored */
+    phase = rd_interface->async_phase;
+    ticket = rd_interface->async_ticket;
+    prefetch->busy = 1;
+    RdAsyncWindowDrain(rd_interface, &prefetch->window);
+    prefetch->busy = 0;
+    RdAsyncPhase(rd_interface, phase, &ticket);
+}
+
+/* ================================================================== */
+/* replies of loads in flight are lost with the link, they are sent again */
+void rd_prefetch_forget(RD_INTERFACE* rd_interface)
+{
+    int i;
+    RD_PREFETCH* prefetch = rd_interface->prefetch;
+
+    if (prefetch == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < prefetch->count; i++)
+    {
+        if (prefetch->entries[i].state == RD_PREFETCH_SENT)
+        {
+            prefetch->entries[i].state = RD_PREFETCH_DECLARED;
+        }
+    }
+    prefetch->window.count = 0;
+}
+
+/* ================================================================== */
+/* declare a load, one ready or in flight is kept */
+static int rd_prefetch_declare(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, const char* label,
+    RD_UWORD index_start, RD_UWORD index_step, RD_UWORD index_count)
+{
+    int ret;
+    RD_PREFETCH_ENTRY* entry;
+
+    ret = rd_prefetch_entry(rd_interface, type, label, index_start, index_step, index_count, &entry);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (entry->state == RD_PREFETCH_FAILED || (entry->state == RD_PREFETCH_READY && !rd_prefetch_ready(rd_interface, entry)))
+    {
+        entry->state = RD_PREFETCH_DECLARED;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdPrefetchImage */
+int RdPrefetchImage(RD_INTERFACE* rd_interface, const char* image_label)
+{
+    return rd_prefetch_declare(rd_interface, RD_RESOURCE_IMAGE, image_label, 0, 0, 0);
+}
+
+/* ================================================================== */
+/* RdPrefetchImageList */
+int RdPrefetchImageList(RD_INTERFACE* rd_interface, const char* prefix, RD_UWORD index_start,
+    RD_UWORD index_step, RD_UWORD index_count)
+{
+    return rd_prefetch_declare(rd_interface, RD_RESOURCE_IMAGE_LIST, prefix, index_start, index_step, index_count);
+}
+
+/* ================================================================== */
+/* RdPrefetchPoll */
+int RdPrefetchPoll(RD_INTERFACE* rd_interface)
+{
+    int i, ret;
+    RD_PREFETCH* prefetch;
+    RD_PREFETCH_ENTRY* entry;
+    _RD_CHECK_INTERFACE();
+
+    prefetch = rd_interface->prefetch;
+    if (prefetch == NULL)
+    {
+        return 0;
+    }
+    /* the link is busy until every reply was read, loads sent before included */
+    if (rd_interface->flow.in_flight > 0 || prefetch->window.count > 0)
+    {
+        return 0;
+    }
+    /* the next command waits for the replies of every load sent, max_pending of them at most */
+    RdAsyncWindowInit(rd_interface, &prefetch->window, rd_prefetch_send, rd_prefetch_done, prefetch);
+    /* a load is never sent directly, nor ahead of the commands of a batch */
+    if (prefetch->window.direct)
+    {
+        return 0;
+    }
+    prefetch->busy = 1;
+    for (i = 0; i < prefetch->count; i++)
+    {
+        entry = &prefetch->entries[i];
+        if (entry->state != RD_PREFETCH_DECLARED)
+        {
+            continue;
+        }
+        entry->state = RD_PREFETCH_SENT;
+        ret = RdAsyncWindowTrySend(rd_interface, &prefetch->window, i);
+        /* the window or the flow budget is full, the rest is sent by a later poll */
+        if (ret == RD_FLOW_BLOCKED)
+        {
+            entry->state = RD_PREFETCH_DECLARED;
+            break;
+        }
+        if (ret < 0)
+        {
+            entry->state = RD_PREFETCH_FAILED;
+            entry->error = ret;
+        }
+    }
+    prefetch->busy = 0;
+    /* frames held by RdTxCoalesce would only go out with the next command */
+    return RdTxFlush(rd_interface);
+}
+
+/* ================================================================== */
+/* id of a load, loaded directly when it was not prefetched */
+static int rd_prefetch_id(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, const char* label,
+    RD_UWORD index_start, RD_UWORD index_step, RD_UWORD index_count, RD_ID* id)
+{
+    int ret;
+    RD_PREFETCH_ENTRY* entry;
+
+    ret = rd_prefetch_entry(rd_interface, type, label, index_start, index_step, index_count, &entry);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (entry->state == RD_PREFETCH_SENT)
+    {
+        rd_prefetch_complete(rd_interface);
+    }
+    if (rd_prefetch_ready(rd_interface, entry))
+    {
+        rd_interface->prefetch->hits++;
+        *id = entry->id;
+        return 0;
+    }
+    rd_interface->prefetch->misses++;
+    ret = rd_prefetch_load(rd_interface, entry);
+    entry->state = (ret == 0) ? RD_PREFETCH_READY : RD_PREFETCH_FAILED;
+    entry->error = ret;
+    if (ret < 0)
+    {
+        return ret;
+    }
+    *id = entry->id;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdPrefetchImageId */
+int RdPrefetchImageId(RD_INTERFACE* rd_interface, const char* image_label, RD_ID* image_id)
+{
+    return rd_prefetch_id(rd_interface, RD_RESOURCE_IMAGE, image_label, 0, 0, 0, image_id);
+}
+
+/* ================================================================== */
+/* RdPrefetchImageListId */
+int RdPrefetchImageListId(RD_INTERFACE* rd_interface, const char* prefix, RD_UWORD index_start,
+    RD_UWORD index_step, RD_UWORD index_count, RD_ID* image_list_id)
+{
+    return rd_prefetch_id(rd_interface, RD_RESOURCE_IMAGE_LIST, prefix, index_start, index_step, index_count,
+        image_list_id);
+}
+
+/* ================================================================== */
+/* RdPrefetchReport */
+void RdPrefetchReport(RD_INTERFACE* rd_interface, FILE* file)
+{
+    RD_PREFETCH* prefetch;
+
+    if (rd_interface == NULL || rd_interface->prefetch == NULL)
+    {
+        return;
+    }
+    prefetch = rd_interface->prefetch;
+    fprintf(file, "  %d labels, %d in flight, %ld prefetched, %ld hits, %ld loaded on demand\n",
+        prefetch->count, prefetch->window.count, prefetch->loaded, prefetch->hits, prefetch->misses);
+}
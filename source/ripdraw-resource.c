@@ -0,0 +1,347 @@
+/* ripdraw-resource.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * registry of device resources handed out to the client
+ */
+#include "ripdraw.h"
+
+int rd_cmd_request_init(RD_INTERFACE* rd_interface, RD_COMMAND_IDS cmd_id);
+int rd_cmd_request_append_uword(RD_INTERFACE* rd_interface, RD_UWORD input);
+int rd_cmd_request_process(RD_INTERFACE* rd_interface);
+int rd_cmd_response_receive(RD_INTERFACE* rd_interface);
+void rd_journal_remove(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+void rd_journal_forget(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type);
+
+/* command releasing a resource type and its name, index is RD_RESOURCE_TYPE */
+static const struct
+{
+    RD_COMMAND_IDS cmd_id;
+    const char* name;
+} rd_resource_types[RD_RESOURCE_TYPE_COUNT] =
+{
+    { Cmd_Reset, "all" },
+    { Cmd_ImageRelease, "image" },
+    { Cmd_ImageDelete, "image write" },
+    { Cmd_ImageListRelease, "image list" },
+    { Cmd_ImageListDelete, "image list write" },
+    { Cmd_AnimationDelete, "animation" },
+    { Cmd_FontRelease, "font" },
+    { Cmd_StringDelete, "string write" },
+    { Cmd_CharacterDelete, "character write" },
+    { Cmd_TextWindowDelete, "text window" },
+    { Cmd_LineGraphDeleteWindow, "line graph" },
+    { Cmd_BarGraphDeleteWindow, "bar graph" },
+    { Cmd_TouchMapDelete, "touch map" }
+};
+
+/* ================================================================== */
+/* find live resource by client id */
+RD_RESOURCE* rd_resource_find(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id)
+{
+    int i;
+    for (i = rd_interface->resource_count - 1; i >= 0; i--)
+    {
+        if (rd_interface->resources[i].type == type && rd_interface->resources[i].id == id)
+        {
+            return &rd_interface->resources[i];
+        }
+    }
+    return NULL;
+}
+
+/* ================================================================== */
+/* device id of a resource, unknown ids are passed unchanged */
+RD_ID rd_resource_device_id(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id)
+{
+    RD_RESOURCE* resource = rd_resource_find(rd_interface, type, id);
+    return resource ? resource->device_id : id;
+}
+
+/* ================================================================== */
+/* register resource created by the device, client id is returned in id */
+int rd_resource_register(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID device_id, RD_ID* id)
+{
+    RD_RESOURCE* resource;
+    RD_ID client_id = device_id;
+    _RD_CHECK_INTERFACE();
+
+    /* after a reconnect the device may hand out an id the client still uses */
+    if (rd_interface->remapped)
+    {
+        while (rd_resource_find(rd_interface, type, client_id))
+        {
+            client_id++;
+        }
+    }
+    if (rd_interface->resource_count == rd_interface->resource_capacity)
+    {
+#ifdef RD_NO_HEAP
+        fprintf(stderr, "more than %d resources\n", RD_NO_HEAP_RESOURCES);
+        return -0120102;
+#else
+        int capacity = rd_interface->resource_capacity ? rd_interface->resource_capacity * 2 : 64;
+        RD_RESOURCE* tmp = (RD_RESOURCE*) realloc(rd_interface->resources, capacity * sizeof(RD_RESOURCE));
+        if (!tmp)
+        {
+            fprintf(stderr, "unable to allocate memory\n");
+            return -0120101;
+        }
+        rd_interface->resources = tmp;
+        rd_interface->resource_capacity = capacity;
+#endif
+    }
+    resource = &rd_interface->resources[rd_interface->resource_count++];
+    resource->type = type;
+    resource->id = client_id;
+    resource->device_id = device_id;
+    resource->owner = rd_interface->resource_owner;
+    resource->serial = ++rd_interface->resource_serial;
+    *id = client_id;
+    return 0;
+}
+
+/* ================================================================== */
+/* unregister released resource, newest resources are searched first */
+void rd_resource_unregister(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id)
+{
+    int i;
+    for (i = rd_interface->resource_count - 1; i >= 0; i--)
+    {
+        if (rd_interface->resources[i].type == type && rd_interface->resources[i].id == id)
+        {
+            rd_interface->resource_count--;
+            memmove(&rd_interface->resources[i], &rd_interface->resources[i + 1],
+                (rd_interface->resource_count - i) * sizeof(RD_RESOURCE));
+            rd_journal_remove(rd_interface, type, id);
+            return;
+        }
+    }
+}
+
+/* ================================================================== */
+/* forget resources of a type, or all, removed by the device itself */
+void rd_resource_forget(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type)
+{
+    int i, count = 0;
+
+    /* reset of a journal replay, resources are created again */
+    if (rd_interface->replaying)
+    {
+        return;
+    }
+    rd_journal_forget(rd_interface, type);
+    if (type == RD_RESOURCE_ALL)
+    {
+        /* no client id is in use any more */
+        rd_interface->remapped = 0;
+    }
+    for (i = 0; i < rd_interface->resource_count; i++)
+    {
+        if (type != RD_RESOURCE_ALL && rd_interface->resources[i].type != type)
+        {
+            rd_interface->resources[count++] = rd_interface->resources[i];
+        }
+    }
+    rd_interface->resource_count = count;
+}
+
+/* ================================================================== */
+/* RdResourceSetOwner */
+int RdResourceSetOwner(RD_INTERFACE* rd_interface, int owner)
+{
+    int previous;
+    _RD_CHECK_INTERFACE();
+
+    previous = rd_interface->resource_owner;
+    rd_interface->resource_owner = owner;
+    return previous;
+}
+
+/* ================================================================== */
+/* RdResourceCount */
+int RdResourceCount(RD_INTERFACE* rd_interface, int owner)
+{
+    int i, count = 0;
+    _RD_CHECK_INTERFACE();
+
+    for (i = 0; i < rd_interface->resource_count; i++)
+    {
+        if (owner < 0 || rd_interface->resources[i].owner == owner)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* ================================================================== */
+/* RdResourceIsLive */
+int RdResourceIsLive(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id)
+{
+    if (rd_interface == NULL)
+    {
+        return 0;
+    }
+    return rd_resource_find(rd_interface, type, id) != NULL;
+}
+
+/* ================================================================== */
+/* RdResourceSerial */
+unsigned int RdResourceSerial(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id)
+{
+    RD_RESOURCE* resource;
+
+    if (rd_interface == NULL)
+    {
+        return 0;
+    }
+    resource = rd_resource_find(rd_interface, type, id);
+    return resource ? resource->serial : 0;
+}
+
+/* ================================================================== */
+/* live resource by serial, NULL when it was released */
+static RD_RESOURCE* rd_resource_find_serial(RD_INTERFACE* rd_interface, unsigned int serial)
+{
+    int i;
+    for (i = rd_interface->resource_count - 1; i >= 0; i--)
+    {
+        if (rd_interface->resources[i].serial == serial)
+        {
+            return &rd_interface->resources[i];
+        }
+    }
+    return NULL;
+}
+
+/* ================================================================== */
+/* release of the resource with a serial, sent or completed in the current phase */
+static int rd_resource_release(RD_INTERFACE* rd_interface, void* context, int serial)
+{
+    int ret;
+    RD_RESOURCE* resource = rd_resource_find_serial(rd_interface, (unsigned int) serial);
+
+    (void) context;
+    if (resource == NULL)
+    {
+        return 0;
+    }
+    ret = rd_cmd_request_init(rd_interface, rd_resource_types[resource->type].cmd_id);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    ret = rd_cmd_request_append_uword(rd_interface, resource->device_id);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    ret = rd_cmd_request_process(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_cmd_response_receive(rd_interface);
+}
+
+/* ================================================================== */
+/* the resource is unregistered once the device acknowledged its release, first error is kept */
+static void rd_resource_release_done(RD_INTERFACE* rd_interface, void* context, int serial, int result)
+{
+    int* error = (int*) context;
+    RD_RESOURCE* resource;
+
+    if (result < 0)
+    {
+        if (*error == 0)
+        {
+            *error = result;
+        }
+        return;
+    }
+    resource = rd_resource_find_serial(rd_interface, (unsigned int) serial);
+    if (resource)
+    {
+        rd_resource_unregister(rd_interface, resource->type, resource->id);
+    }
+}
+
+/* ================================================================== */
+/* RdResourceReleaseOwner */
+int RdResourceReleaseOwner(RD_INTERFACE* rd_interface, int owner)
+{
+    int ret = 0, i, error = 0;
+    RD_RESOURCE* resource;
+    RD_ASYNC_WINDOW window;
+    _RD_CHECK_INTERFACE();
+
+    /* releases are split so that max_pending of them are in flight, a batch queues them */
+    RdAsyncWindowInit(rd_interface, &window, rd_resource_release, rd_resource_release_done, &error);
+    /* newest first, writes are deleted before the images and fonts they use
+       an acknowledged release only removes entries above i, the index stays valid */
+    for (i = rd_interface->resource_count - 1; i >= 0 && ret == 0 && error == 0; i--)
+    {
+        resource = &rd_interface->resources[i];
+        if (owner >= 0 && resource->owner != owner)
+        {
+            continue;
+        }
+        ret = RdAsyncWindowSend(rd_interface, &window, (int) resource->serial);
+    }
+    /* every reply is read, resources whose release failed or was never sent stay registered */
+    RdAsyncWindowDrain(rd_interface, &window);
+    return (ret < 0) ? ret : error;
+}
+
+/* ================================================================== */
+/* RdResourceReport */
+void RdResourceReport(RD_INTERFACE* rd_interface, FILE* file)
+{
+    int i;
+    RD_RESOURCE* resource;
+
+    if (rd_interface == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < rd_interface->resource_count; i++)
+    {
+        resource = &rd_interface->resources[i];
+        fprintf(file, "  %s %d, owner %d\n", rd_resource_types[resource->type].name, resource->id, resource->owner);
+    }
+}
+
+/* ================================================================== */
+/* print number of resources never released per type */
+void rd_resource_report_leaks(RD_INTERFACE* rd_interface)
+{
+    int counts[RD_RESOURCE_TYPE_COUNT];
+    int i, count = 0;
+
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < rd_interface->resource_count; i++)
+    {
+        /* the scene of a live warm start file is left on the device for the next run */
+        if (rd_interface->warm_file[0] && rd_interface->resources[i].serial <= rd_interface->warm_serial)
+        {
+            continue;
+        }
+        counts[rd_interface->resources[i].type]++;
+        count++;
+    }
+    if (count == 0)
+    {
+        return;
+    }
+    fprintf(stderr, "device resources not released:");
+    for (i = 0; i < RD_RESOURCE_TYPE_COUNT; i++)
+    {
+        if (counts[i])
+        {
+            fprintf(stderr, " %s %d", rd_resource_types[i].name, counts[i]);
+        }
+    }
+    fprintf(stderr, "\n");
+}
@@ -6,6 +6,7 @@
  */
 
 #include "ripdraw.h"
+#include <time.h>
 
 typedef struct _RD_INTERFACE_SERIAL
 {
@@ -151,3 +152,12 @@ int rd_extint_read(RD_INTERFACE* rd_interface, RD_BYTE* data_ptr, int data_len)
     while (total_read < data_len);
     return 0;
 }
+
+/* ================================================================== */
+/* monotonic clock in microseconds */
+long long rd_extint_clock_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
@@ -0,0 +1,201 @@
+/* ripdraw-shadow.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * host shadow copy of raw pixel layers, only changed tiles are uploaded
+ */
+#include "ripdraw.h"
+
+int rd_layer_write_raw_pixels_stride(RD_INTERFACE* rd_interface, RD_ID layer_id,
+RD_POSITION position, RD_SIZE pixel_size, const RD_COLOR* pixels, int stride);
+
+#define RD_SHADOW_DEFAULT_TILE		32
+
+/* ================================================================== */
+/* RdLayerShadowInit */
+int RdLayerShadowInit(RD_LAYER_SHADOW* shadow, RD_ID layer_id, RD_POSITION position, RD_SIZE size, RD_SIZE tile_size)
+{
+    if (shadow == NULL)
+    {
+        fprintf(stderr, "shadow should not NULL\n");
+        return -030101;
+    }
+    memset(shadow, 0, sizeof(RD_LAYER_SHADOW));
+    shadow->pixels = (RD_COLOR*) malloc(size.width * size.height * sizeof(RD_COLOR) + 1);
+    if (!shadow->pixels)
+    {
+        fprintf(stderr, "unable to allocate memory\n");
+        return -030102;
+    }
+    shadow->layer_id = layer_id;
+    shadow->position = position;
+    shadow->size = size;
+    shadow->tile_size.width = tile_size.width ? tile_size.width : RD_SHADOW_DEFAULT_TILE;
+    shadow->tile_size.height = tile_size.height ? tile_size.height : RD_SHADOW_DEFAULT_TILE;
+    shadow->is_valid = 0;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdLayerShadowFree */
+int RdLayerShadowFree(RD_LAYER_SHADOW* shadow)
+{
+    if (shadow)
+    {
+        RdFreeData(shadow->pixels);
+        shadow->pixels = NULL;
+        shadow->is_valid = 0;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdLayerShadowInvalidate */
+void RdLayerShadowInvalidate(RD_LAYER_SHADOW* shadow)
+{
+    if (shadow)
+    {
+        shadow->is_valid = 0;
+    }
+}
+
+/* ================================================================== */
+/* check whether a tile differs from the shadow copy */
+static int rd_shadow_tile_changed(const RD_LAYER_SHADOW* shadow, const RD_COLOR* pixels,
+int x, int y, int width, int height)
+{
+    int row, offset;
+    for (row = y; row < y + height; row++)
+    {
+        /* memcmp is vectorised by the C library */
+        offset = row * shadow->size.width + x;
+        if (memcmp(shadow->pixels + offset, pixels + offset, width * sizeof(RD_COLOR)) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* upload a rectangle of the new buffer and copy it into the shadow */
+static int rd_shadow_upload(RD_INTERFACE* rd_interface, RD_LAYER_SHADOW* shadow, const RD_COLOR* pixels,
+int x, int y, int width, int height)
+{
+    int ret, row, offset;
+
+    offset = y * shadow->size.width + x;
+    ret = rd_layer_write_raw_pixels_stride(rd_interface, shadow->layer_id,
+        Rd_Position(shadow->position.x + x, shadow->position.y + y), Rd_Size(width, height),
+        pixels + offset, shadow->size.width);
+    if (ret < 0)
+    {
+        shadow->is_valid = 0;
+        return ret;
+    }
+    for (row = 0; row < height; row++, offset += shadow->size.width)
+    {
+        memcpy(shadow->pixels + offset, pixels + offset, width * sizeof(RD_COLOR));
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdLayerShadowUpdate */
+int RdLayerShadowUpdate(RD_INTERFACE* rd_interface, RD_LAYER_SHADOW* shadow, const RD_COLOR* pixels)
+{
+    int ret;
+    int tx, ty, tile_width, tile_height, height;
+    int run_start, run_end;
+    /* pending rectangle, extended downwards while tile rows change over the same columns */
+    int rect_x, rect_width, rect_y, rect_height;
+
+    if (shadow == NULL || shadow->pixels == NULL || pixels == NULL)
+    {
+        fprintf(stderr, "shadow should not NULL\n");
+        return -030201;
+    }
+
+    if (!shadow->is_valid)
+    {
+        ret = rd_shadow_upload(rd_interface, shadow, pixels, 0, 0, shadow->size.width, shadow->size.height);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        shadow->is_valid = 1;
+        return 0;
+    }
+
+    tile_width = shadow->tile_size.width;
+    tile_height = shadow->tile_size.height;
+    rect_height = 0;
+    rect_x = rect_y = rect_width = 0;
+    for (ty = 0; ty < shadow->size.height; ty += tile_height)
+    {
+        height = (shadow->size.height - ty < tile_height) ? shadow->size.height - ty : tile_height;
+        run_start = -1;
+        run_end = -1;
+        for (tx = 0; tx < shadow->size.width; tx += tile_width)
+        {
+            int width = (shadow->size.width - tx < tile_width) ? shadow->size.width - tx : tile_width;
+            if (!rd_shadow_tile_changed(shadow, pixels, tx, ty, width, height))
+            {
+                continue;
+            }
+            if (run_start >= 0 && run_end != tx)
+            {
+                /* second run in this tile row, flush pending rectangle and the first run */
+                if (rect_height > 0)
+                {
+                    ret = rd_shadow_upload(rd_interface, shadow, pixels, rect_x, rect_y, rect_width, rect_height);
+                    if (ret < 0)
+                    {
+                        return ret;
+                    }
+                    rect_height = 0;
+                }
+                ret = rd_shadow_upload(rd_interface, shadow, pixels, run_start, ty, run_end - run_start, height);
+                if (ret < 0)
+                {
+                    return ret;
+                }
+                run_start = -1;
+            }
+            if (run_start < 0)
+            {
+                run_start = tx;
+            }
+            run_end = tx + width;
+        }
+
+        if (run_start >= 0 && rect_height > 0 && rect_x == run_start && rect_width == run_end - run_start
+            && rect_y + rect_height == ty)
+        {
+            rect_height += height;
+            continue;
+        }
+        if (rect_height > 0)
+        {
+            ret = rd_shadow_upload(rd_interface, shadow, pixels, rect_x, rect_y, rect_width, rect_height);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            rect_height = 0;
+        }
+        if (run_start >= 0)
+        {
+            rect_x = run_start;
+            rect_width = run_end - run_start;
+            rect_y = ty;
+            rect_height = height;
+        }
+    }
+    if (rect_height > 0)
+    {
+        return rd_shadow_upload(rd_interface, shadow, pixels, rect_x, rect_y, rect_width, rect_height);
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+/* ripdraw-state.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * cache of the device state, setters repeating the value in effect are not sent
+ */
+#include "ripdraw.h"
+
+/* ================================================================== */
+/* RdStateCacheEnable */
+int RdStateCacheEnable(RD_INTERFACE* rd_interface, int enable)
+{
+    _RD_CHECK_INTERFACE();
+
+    rd_interface->state.disabled = !enable;
+    RdStateCacheForget(rd_interface);
+    return 0;
+}
+
+/* ================================================================== */
+/* RdStateCacheForget */
+void RdStateCacheForget(RD_INTERFACE* rd_interface)
+{
+    int i;
+
+    if (rd_interface == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < RD_STATE_LAYERS; i++)
+    {
+        rd_interface->state.layers[i].known = 0;
+    }
+    rd_interface->state.has_backlight = 0;
+}
+
+/* ================================================================== */
+/* cached state of a layer, NULL when it is not cached */
+RD_LAYER_STATE* rd_state_layer(RD_INTERFACE* rd_interface, RD_ID layer_id)
+{
+    if (rd_interface == NULL || rd_interface->state.disabled || rd_interface->broadcast
+        || layer_id >= RD_STATE_LAYERS)
+    {
+        return NULL;
+    }
+    return &rd_interface->state.layers[layer_id];
+}
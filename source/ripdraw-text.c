@@ -0,0 +1,665 @@
+/* ripdraw-text.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * host-side helpers for text
+ */
+#include "ripdraw.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#else
+#include <pthread.h>
+#endif
+
+long long rd_extint_clock_us(void);
+
+/* consecutive small or large updates before a readout changes between characters and string */
+#define RD_READOUT_SETTLE		4
+/* room kept after the log lines for the drop summary */
+#define RD_LOG_SUMMARY_LENGTH		40
+
+/* ================================================================== */
+/* right align text in field of readout length */
+static int rd_readout_format(const RD_READOUT* readout, const char* text, char* field)
+{
+    int len = strlen(text);
+    if (len > readout->length)
+    {
+        fprintf(stderr, "readout text too long: %s\n", text);
+        return -1;
+    }
+    memset(field, ' ', readout->length - len);
+    memcpy(field + readout->length - len, text, len + 1);
+    return 0;
+}
+
+/* ================================================================== */
+/* write every character of the field on its own */
+static int rd_readout_write_characters(RD_INTERFACE* rd_interface, RD_READOUT* readout)
+{
+    int ret, i;
+    for (i = 0; i < readout->length; i++)
+    {
+        ret = Rd_CharacterWrite(rd_interface, readout->layer_id,
+            Rd_Position(readout->position.x + i * readout->advance, readout->position.y),
+            readout->font_id, readout->color, (RD_BYTE) readout->text[i], &readout->character_ids[i]);
+        if (ret < 0)
+        {
+            /* keep the characters already written deletable */
+            readout->written = i;
+            return ret;
+        }
+    }
+    readout->written = readout->length;
+    return 0;
+}
+
+/* ================================================================== */
+/* delete characters or string currently shown */
+static int rd_readout_clear(RD_INTERFACE* rd_interface, RD_READOUT* readout)
+{
+    int ret;
+    if (readout->string_mode)
+    {
+        ret = Rd_StringDelete(rd_interface, readout->string_id);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        readout->string_mode = 0;
+    }
+    while (readout->written > 0)
+    {
+        ret = Rd_CharacterDelete(rd_interface, readout->character_ids[readout->written - 1]);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        readout->written--;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdReadoutCreate */
+int RdReadoutCreate(RD_INTERFACE* rd_interface, RD_READOUT* readout, RD_ID layer_id, RD_POSITION position,
+RD_ID font_id, RD_COLOR color, RD_UWORD advance, int length, int threshold, const char* text)
+{
+    if (readout == NULL || text == NULL)
+    {
+        fprintf(stderr, "readout should not NULL\n");
+        return -060101;
+    }
+    if (length <= 0 || length > RD_READOUT_MAX_LENGTH)
+    {
+        fprintf(stderr, "readout length should be 1 to %d\n", RD_READOUT_MAX_LENGTH);
+        return -060102;
+    }
+    memset(readout, 0, sizeof(RD_READOUT));
+    readout->layer_id = layer_id;
+    readout->position = position;
+    readout->font_id = font_id;
+    readout->color = color;
+    readout->advance = advance;
+    readout->length = length;
+    readout->threshold = threshold;
+    if (rd_readout_format(readout, text, readout->text) < 0)
+    {
+        return -060103;
+    }
+    return rd_readout_write_characters(rd_interface, readout);
+}
+
+/* ================================================================== */
+/* RdReadoutUpdate */
+int RdReadoutUpdate(RD_INTERFACE* rd_interface, RD_READOUT* readout, const char* text)
+{
+    int ret, i, changed;
+    char field[RD_READOUT_MAX_LENGTH + 1];
+
+    if (readout == NULL || text == NULL)
+    {
+        fprintf(stderr, "readout should not NULL\n");
+        return -060201;
+    }
+    if (rd_readout_format(readout, text, field) < 0)
+    {
+        return -060202;
+    }
+    changed = 0;
+    for (i = 0; i < readout->length; i++)
+    {
+        changed += (field[i] != readout->text[i]);
+    }
+    if (changed == 0)
+    {
+        return 0;
+    }
+
+    if (readout->string_mode)
+    {
+        /* go back to characters only after the value has settled */
+        readout->small_updates = (changed <= readout->threshold) ? readout->small_updates + 1 : 0;
+        if (readout->small_updates < RD_READOUT_SETTLE)
+        {
+            ret = Rd_StringReplace(rd_interface, readout->string_id, field);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            memcpy(readout->text, field, readout->length + 1);
+            return 0;
+        }
+        ret = rd_readout_clear(rd_interface, readout);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        readout->large_updates = 0;
+        memcpy(readout->text, field, readout->length + 1);
+        return rd_readout_write_characters(rd_interface, readout);
+    }
+
+    /* one large change is cheaper replaced than the characters torn down for a string */
+    readout->large_updates = (changed > readout->threshold) ? readout->large_updates + 1 : 0;
+    if (readout->large_updates >= RD_READOUT_SETTLE)
+    {
+        /* replacing most characters every time costs more than one string */
+        ret = rd_readout_clear(rd_interface, readout);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        ret = Rd_StringWrite(rd_interface, readout->layer_id, readout->position, readout->font_id,
+            readout->color, RD_HDIRECTION_LEFT, field, &readout->string_id);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        readout->string_mode = 1;
+        readout->small_updates = 0;
+        readout->large_updates = 0;
+        memcpy(readout->text, field, readout->length + 1);
+        return 0;
+    }
+
+    for (i = 0; i < readout->length; i++)
+    {
+        if (field[i] != readout->text[i])
+        {
+            ret = Rd_CharacterReplace(rd_interface, readout->character_ids[i], (RD_BYTE) field[i]);
+            if (ret < 0)
+            {
+                return ret;
+            }
+            readout->text[i] = field[i];
+        }
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdReadoutDelete */
+int RdReadoutDelete(RD_INTERFACE* rd_interface, RD_READOUT* readout)
+{
+    if (readout == NULL)
+    {
+        fprintf(stderr, "readout should not NULL\n");
+        return -060301;
+    }
+    return rd_readout_clear(rd_interface, readout);
+}
+
+/* ================================================================== */
+/* RdConsoleCreate */
+int RdConsoleCreate(RD_INTERFACE* rd_interface, RD_CONSOLE* console, RD_ID layer_id, RD_POSITION position,
+const char* font_label, RD_COLOR color, RD_SIZE cell_size, int rows, int columns)
+{
+    int ret, count;
+
+    if (console == NULL)
+    {
+        fprintf(stderr, "console should not NULL\n");
+        return -060401;
+    }
+    if (rows <= 0 || columns <= 0)
+    {
+        fprintf(stderr, "console should have rows and columns\n");
+        return -060402;
+    }
+    memset(console, 0, sizeof(RD_CONSOLE));
+    count = rows * columns;
+    console->cells = (char*) malloc(count);
+    console->shown = (char*) malloc(count);
+    console->ids = (RD_ID*) malloc(count * sizeof(RD_ID));
+    console->damaged = (RD_BYTE*) malloc(rows);
+    if (!console->cells || !console->shown || !console->ids || !console->damaged)
+    {
+        RdConsoleDelete(NULL, console);
+        fprintf(stderr, "unable to allocate memory\n");
+        return -060403;
+    }
+    /* space is an empty cell, nothing is written for it */
+    memset(console->cells, ' ', count);
+    memset(console->shown, ' ', count);
+    memset(console->damaged, 0, rows);
+    console->layer_id = layer_id;
+    console->position = position;
+    console->color = color;
+    console->cell_size = cell_size;
+    console->rows = rows;
+    console->columns = columns;
+
+    ret = Rd_FontLoad(rd_interface, font_label, &console->font_id);
+    if (ret < 0)
+    {
+        RdConsoleDelete(NULL, console);
+        return ret;
+    }
+    console->font_loaded = 1;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdConsoleDelete */
+int RdConsoleDelete(RD_INTERFACE* rd_interface, RD_CONSOLE* console)
+{
+    int ret = 0, i;
+
+    if (console == NULL)
+    {
+        fprintf(stderr, "console should not NULL\n");
+        return -060501;
+    }
+    if (rd_interface && console->shown)
+    {
+        for (i = 0; i < console->rows * console->columns && ret == 0; i++)
+        {
+            if (console->shown[i] != ' ')
+            {
+                ret = Rd_CharacterDelete(rd_interface, console->ids[i]);
+            }
+        }
+    }
+    if (rd_interface && console->font_loaded && ret == 0)
+    {
+        ret = Rd_FontRelease(rd_interface, console->font_id);
+    }
+    RdFreeData(console->cells);
+    RdFreeData(console->shown);
+    RdFreeData(console->ids);
+    RdFreeData(console->damaged);
+    memset(console, 0, sizeof(RD_CONSOLE));
+    return ret;
+}
+
+/* ================================================================== */
+/* move all rows up by one and clear the last row
+   character writes cannot move on the device, rows whose text changed are replaced cell by cell */
+static void rd_console_scroll(RD_CONSOLE* console)
+{
+    int row;
+    char* cells;
+
+    for (row = 0; row < console->rows; row++)
+    {
+        cells = console->cells + row * console->columns;
+        if (row < console->rows - 1)
+        {
+            if (memcmp(cells, cells + console->columns, console->columns) != 0)
+            {
+                memcpy(cells, cells + console->columns, console->columns);
+                console->damaged[row] = 1;
+            }
+        }
+        /* blank when every cell equals the first one and that one is a space */
+        else if (cells[0] != ' ' || memcmp(cells, cells + 1, console->columns - 1) != 0)
+        {
+            memset(cells, ' ', console->columns);
+            console->damaged[row] = 1;
+        }
+    }
+}
+
+/* ================================================================== */
+/* RdConsoleWrite */
+void RdConsoleWrite(RD_CONSOLE* console, const char* text)
+{
+    for (; *text; text++)
+    {
+        if (*text == '\n')
+        {
+            console->cursor_column = 0;
+            console->cursor_row++;
+        }
+        else if (*text == '\r')
+        {
+            console->cursor_column = 0;
+            continue;
+        }
+        else
+        {
+            if (console->cursor_column == console->columns)
+            {
+                /* wrap to next line */
+                console->cursor_column = 0;
+                console->cursor_row++;
+            }
+            if (console->cursor_row == console->rows)
+            {
+                rd_console_scroll(console);
+                console->cursor_row--;
+            }
+            console->cells[console->cursor_row * console->columns + console->cursor_column] =
+                (*text == '\t') ? ' ' : *text;
+            console->damaged[console->cursor_row] = 1;
+            console->cursor_column++;
+            continue;
+        }
+        if (console->cursor_row == console->rows)
+        {
+            rd_console_scroll(console);
+            console->cursor_row--;
+        }
+    }
+}
+
+/* ================================================================== */
+/* RdConsoleClear */
+void RdConsoleClear(RD_CONSOLE* console)
+{
+    memset(console->cells, ' ', console->rows * console->columns);
+    memset(console->damaged, 1, console->rows);
+    console->cursor_row = 0;
+    console->cursor_column = 0;
+}
+
+/* ================================================================== */
+/* RdConsoleSetCursor */
+void RdConsoleSetCursor(RD_CONSOLE* console, int row, int column)
+{
+    console->cursor_row = (row < 0) ? 0 : (row >= console->rows) ? console->rows - 1 : row;
+    console->cursor_column = (column < 0) ? 0 : (column > console->columns) ? console->columns : column;
+}
+
+/* console being flushed and the first error of its cell commands */
+struct console_flush
+{
+    RD_CONSOLE* console;
+    int error;
+};
+
+/* ================================================================== */
+/* command changing shown cell i to the cell content, sent or completed in the current phase */
+static int rd_console_cell(RD_INTERFACE* rd_interface, void* context, int i)
+{
+    RD_CONSOLE* console = ((struct console_flush*) context)->console;
+    int row = i / console->columns;
+    int column = i % console->columns;
+    char c = console->cells[i];
+
+    if (console->shown[i] == ' ')
+    {
+        return Rd_CharacterWrite(rd_interface, console->layer_id,
+            Rd_Position(console->position.x + column * console->cell_size.width,
+                console->position.y + row * console->cell_size.height),
+            console->font_id, console->color, (RD_BYTE) c, &console->ids[i]);
+    }
+    if (c == ' ')
+    {
+        return Rd_CharacterDelete(rd_interface, console->ids[i]);
+    }
+    return Rd_CharacterReplace(rd_interface, console->ids[i], (RD_BYTE) c);
+}
+
+/* ================================================================== */
+/* cell shown once its command completed */
+static void rd_console_cell_done(RD_INTERFACE* rd_interface, void* context, int i, int result)
+{
+    struct console_flush* flush = (struct console_flush*) context;
+
+    (void) rd_interface;
+    if (result == 0)
+    {
+        flush->console->shown[i] = flush->console->cells[i];
+    }
+    else if (flush->error == 0)
+    {
+        flush->error = result;
+    }
+}
+
+/* ================================================================== */
+/* RdConsoleFlush */
+int RdConsoleFlush(RD_INTERFACE* rd_interface, RD_CONSOLE* console)
+{
+    int ret = 0, row, column, i;
+    struct console_flush flush;
+    RD_ASYNC_WINDOW window;
+
+    if (console == NULL || console->cells == NULL)
+    {
+        fprintf(stderr, "console should not NULL\n");
+        return -060601;
+    }
+    _RD_CHECK_INTERFACE();
+
+    /* cell commands are split so that max_pending of them are in flight */
+    flush.console = console;
+    flush.error = 0;
+    RdAsyncWindowInit(rd_interface, &window, rd_console_cell, rd_console_cell_done, &flush);
+    for (row = 0; row < console->rows && ret == 0 && flush.error == 0; row++)
+    {
+        if (!console->damaged[row])
+        {
+            continue;
+        }
+        for (column = 0; column < console->columns && ret == 0 && flush.error == 0; column++)
+        {
+            i = row * console->columns + column;
+            if (console->cells[i] != console->shown[i])
+            {
+                ret = RdAsyncWindowSend(rd_interface, &window, i);
+            }
+        }
+    }
+    /* every reply is read, the first error is returned */
+    RdAsyncWindowDrain(rd_interface, &window);
+    if (ret == 0)
+    {
+        ret = flush.error;
+    }
+    if (ret < 0)
+    {
+        /* rows stay damaged, the next flush sends the cells not shown yet */
+        return ret;
+    }
+    memset(console->damaged, 0, console->rows);
+    return 0;
+}
+
+/* ================================================================== */
+/* log sink lock, log lines may come from any thread */
+static void* rd_log_lock_create(void)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    CRITICAL_SECTION* lock = (CRITICAL_SECTION*) malloc(sizeof(CRITICAL_SECTION));
+    if (lock)
+    {
+        InitializeCriticalSection(lock);
+    }
+#else
+    pthread_mutex_t* lock = (pthread_mutex_t*) malloc(sizeof(pthread_mutex_t));
+    if (lock && pthread_mutex_init(lock, NULL) != 0)
+    {
+        free(lock);
+        lock = NULL;
+    }
+#endif
+    return lock;
+}
+
+static void rd_log_lock_destroy(void* lock)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    DeleteCriticalSection((CRITICAL_SECTION*) lock);
+#else
+    pthread_mutex_destroy((pthread_mutex_t*) lock);
+#endif
+    free(lock);
+}
+
+static void rd_log_lock(void* lock)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    EnterCriticalSection((CRITICAL_SECTION*) lock);
+#else
+    pthread_mutex_lock((pthread_mutex_t*) lock);
+#endif
+}
+
+static void rd_log_unlock(void* lock)
+{
+#if defined(_WIN32) || defined(_WIN64)
+    LeaveCriticalSection((CRITICAL_SECTION*) lock);
+#else
+    pthread_mutex_unlock((pthread_mutex_t*) lock);
+#endif
+}
+
+/* ================================================================== */
+/* RdLogSinkInit */
+int RdLogSinkInit(RD_LOG_SINK* sink, RD_ID text_window_id, int frame_interval_ms, int max_bytes)
+{
+    if (sink == NULL)
+    {
+        fprintf(stderr, "log sink should not NULL\n");
+        return -060701;
+    }
+    if (max_bytes <= 0 || max_bytes + RD_LOG_SUMMARY_LENGTH + 4 > RD_MAX_PAYLOAD)
+    {
+        fprintf(stderr, "invalid log sink size %d\n", max_bytes);
+        return -060702;
+    }
+    memset(sink, 0, sizeof(RD_LOG_SINK));
+    /* lines are collected in one buffer while the other one is sent */
+    sink->buffer = (char*) malloc(max_bytes + RD_LOG_SUMMARY_LENGTH + 1);
+    sink->sending = (char*) malloc(max_bytes + RD_LOG_SUMMARY_LENGTH + 1);
+    sink->lock = rd_log_lock_create();
+    if (!sink->buffer || !sink->sending || !sink->lock)
+    {
+        RdLogSinkFree(sink);
+        fprintf(stderr, "unable to allocate memory\n");
+        return -060703;
+    }
+    sink->text_window_id = text_window_id;
+    sink->frame_interval_ms = frame_interval_ms;
+    sink->max_bytes = max_bytes;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdLogSinkFree */
+int RdLogSinkFree(RD_LOG_SINK* sink)
+{
+    if (sink)
+    {
+        RdFreeData(sink->buffer);
+        RdFreeData(sink->sending);
+        if (sink->lock)
+        {
+            rd_log_lock_destroy(sink->lock);
+        }
+        memset(sink, 0, sizeof(RD_LOG_SINK));
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdLogSinkWrite */
+void RdLogSinkWrite(RD_LOG_SINK* sink, const char* line)
+{
+    int len = strlen(line);
+
+    rd_log_lock(sink->lock);
+    if (sink->size + len + 1 > sink->max_bytes)
+    {
+        /* budget of this frame is used up, line is only counted */
+        sink->dropped++;
+        sink->total_dropped++;
+    }
+    else
+    {
+        memcpy(sink->buffer + sink->size, line, len);
+        sink->size += len;
+        sink->buffer[sink->size++] = '\n';
+    }
+    rd_log_unlock(sink->lock);
+}
+
+/* ================================================================== */
+/* RdLogSinkFlush */
+int RdLogSinkFlush(RD_INTERFACE* rd_interface, RD_LOG_SINK* sink)
+{
+    char* text;
+    int size, lines, i, ret;
+    unsigned int dropped;
+
+    if (sink == NULL || sink->lock == NULL)
+    {
+        fprintf(stderr, "log sink should not NULL\n");
+        return -061001;
+    }
+    sink->last_flush_us = rd_extint_clock_us();
+
+    /* swap buffers, writers are blocked only for the swap */
+    rd_log_lock(sink->lock);
+    text = sink->buffer;
+    size = sink->size;
+    dropped = sink->dropped;
+    sink->buffer = sink->sending;
+    sink->sending = text;
+    sink->size = 0;
+    sink->dropped = 0;
+    rd_log_unlock(sink->lock);
+
+    lines = 0;
+    for (i = 0; i < size; i++)
+    {
+        if (text[i] == '\n')
+        {
+            lines++;
+        }
+    }
+    if (dropped)
+    {
+        size += sprintf(text + size, "... %u lines dropped\n", dropped);
+    }
+    if (size == 0)
+    {
+        return 0;
+    }
+    text[size] = 0;
+    ret = Rd_TextWindowInsertText(rd_interface, sink->text_window_id, text);
+    if (ret < 0)
+    {
+        /* lines of the frame are lost, the next summary reports them with the ones dropped before */
+        rd_log_lock(sink->lock);
+        sink->dropped += dropped + lines;
+        sink->total_dropped += lines;
+        rd_log_unlock(sink->lock);
+    }
+    return ret;
+}
+
+/* ================================================================== */
+/* RdLogSinkPoll */
+int RdLogSinkPoll(RD_INTERFACE* rd_interface, RD_LOG_SINK* sink)
+{
+    if (rd_extint_clock_us() - sink->last_flush_us < (long long) sink->frame_interval_ms * 1000)
+    {
+        return 0;
+    }
+    return RdLogSinkFlush(rd_interface, sink);
+}
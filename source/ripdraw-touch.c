@@ -0,0 +1,401 @@
+/* ripdraw-touch.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * host registry of touch map regions with a uniform grid index
+ */
+#include "ripdraw.h"
+
+#define RD_TOUCH_DEFAULT_CELL		32
+
+/* ================================================================== */
+/* RdTouchRegistryInit */
+int RdTouchRegistryInit(RD_TOUCH_REGISTRY* registry, RD_SIZE screen_size, RD_SIZE cell_size)
+{
+    if (registry == NULL)
+    {
+        fprintf(stderr, "touch registry should not NULL\n");
+        return -070101;
+    }
+    if (screen_size.width == 0 || screen_size.height == 0)
+    {
+        fprintf(stderr, "invalid screen size\n");
+        return -070102;
+    }
+    memset(registry, 0, sizeof(RD_TOUCH_REGISTRY));
+    registry->screen_size = screen_size;
+    registry->cell_size.width = cell_size.width ? cell_size.width : RD_TOUCH_DEFAULT_CELL;
+    registry->cell_size.height = cell_size.height ? cell_size.height : RD_TOUCH_DEFAULT_CELL;
+    registry->grid_columns = (screen_size.width + registry->cell_size.width - 1) / registry->cell_size.width;
+    registry->grid_rows = (screen_size.height + registry->cell_size.height - 1) / registry->cell_size.height;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdTouchRegistryFree */
+int RdTouchRegistryFree(RD_TOUCH_REGISTRY* registry)
+{
+    if (registry)
+    {
+        RdFreeData(registry->regions);
+        RdFreeData(registry->cell_start);
+        RdFreeData(registry->cell_regions);
+        RdFreeData(registry->by_id);
+        registry->regions = NULL;
+        registry->cell_start = NULL;
+        registry->cell_regions = NULL;
+        registry->by_id = NULL;
+        registry->count = 0;
+        registry->capacity = 0;
+        registry->is_indexed = 0;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* bounding box of a region in grid cells, clipped to the screen */
+static void rd_touch_region_cells(const RD_TOUCH_REGISTRY* registry, const RD_TOUCH_REGION* region,
+int* left, int* top, int* right, int* bottom)
+{
+    int x0, y0, x1, y1;
+    if (region->outer_radius)
+    {
+        x0 = region->position.x - region->outer_radius;
+        y0 = region->position.y - region->outer_radius;
+        x1 = region->position.x + region->outer_radius;
+        y1 = region->position.y + region->outer_radius;
+    }
+    else
+    {
+        x0 = region->position.x;
+        y0 = region->position.y;
+        x1 = region->position.x + region->size.width - 1;
+        y1 = region->position.y + region->size.height - 1;
+    }
+    x0 = (x0 < 0) ? 0 : x0;
+    y0 = (y0 < 0) ? 0 : y0;
+    x1 = (x1 >= registry->screen_size.width) ? registry->screen_size.width - 1 : x1;
+    y1 = (y1 >= registry->screen_size.height) ? registry->screen_size.height - 1 : y1;
+    *left = x0 / registry->cell_size.width;
+    *top = y0 / registry->cell_size.height;
+    *right = x1 / registry->cell_size.width;
+    *bottom = y1 / registry->cell_size.height;
+}
+
+/* ================================================================== */
+/* check whether a position is inside a region */
+static int rd_touch_region_contains(const RD_TOUCH_REGION* region, RD_POSITION position)
+{
+    long dx, dy, distance;
+    if (region->outer_radius)
+    {
+        dx = (long) position.x - region->position.x;
+        dy = (long) position.y - region->position.y;
+        distance = dx * dx + dy * dy;
+        return distance <= (long) region->outer_radius * region->outer_radius
+            && distance >= (long) region->inner_radius * region->inner_radius;
+    }
+    return position.x >= region->position.x && position.x - region->position.x < region->size.width
+        && position.y >= region->position.y && position.y - region->position.y < region->size.height;
+}
+
+/* ================================================================== */
+/* compare touch id and region index pairs for qsort */
+static int rd_touch_id_compare(const void* a, const void* b)
+{
+    return ((const int*) a)[0] - ((const int*) b)[0];
+}
+
+/* ================================================================== */
+/* build grid index and id index, regions of a cell are kept in registration order */
+static int rd_touch_registry_index(RD_TOUCH_REGISTRY* registry)
+{
+    int cells, i, x, y, left, top, right, bottom, total;
+    int* cell_start;
+    int* cell_regions;
+    int* by_id;
+
+    cells = registry->grid_columns * registry->grid_rows;
+    cell_start = (int*) calloc(cells + 1, sizeof(int));
+    by_id = (int*) malloc((registry->count + 1) * 2 * sizeof(int));
+    if (!cell_start || !by_id)
+    {
+        RdFreeData(cell_start);
+        RdFreeData(by_id);
+        return -1;
+    }
+    /* count regions per cell, then turn counts into start offsets */
+    for (i = 0; i < registry->count; i++)
+    {
+        rd_touch_region_cells(registry, &registry->regions[i], &left, &top, &right, &bottom);
+        for (y = top; y <= bottom; y++)
+        {
+            for (x = left; x <= right; x++)
+            {
+                cell_start[y * registry->grid_columns + x + 1]++;
+            }
+        }
+    }
+    for (i = 0; i < cells; i++)
+    {
+        cell_start[i + 1] += cell_start[i];
+    }
+    total = cell_start[cells];
+    cell_regions = (int*) malloc((total + 1) * sizeof(int));
+    if (!cell_regions)
+    {
+        free(cell_start);
+        free(by_id);
+        return -1;
+    }
+    for (i = 0; i < registry->count; i++)
+    {
+        rd_touch_region_cells(registry, &registry->regions[i], &left, &top, &right, &bottom);
+        for (y = top; y <= bottom; y++)
+        {
+            for (x = left; x <= right; x++)
+            {
+                cell_regions[cell_start[y * registry->grid_columns + x]++] = i;
+            }
+        }
+    }
+    /* filling moved every start to the next cell */
+    for (i = cells; i > 0; i--)
+    {
+        cell_start[i] = cell_start[i - 1];
+    }
+    cell_start[0] = 0;
+
+    for (i = 0; i < registry->count; i++)
+    {
+        by_id[i * 2] = registry->regions[i].touch_id;
+        by_id[i * 2 + 1] = i;
+    }
+    qsort(by_id, registry->count, 2 * sizeof(int), rd_touch_id_compare);
+
+    RdFreeData(registry->cell_start);
+    RdFreeData(registry->cell_regions);
+    RdFreeData(registry->by_id);
+    registry->cell_start = cell_start;
+    registry->cell_regions = cell_regions;
+    registry->by_id = by_id;
+    registry->is_indexed = 1;
+    return 0;
+}
+
+/* ================================================================== */
+/* append region to registry, index is rebuilt on next lookup */
+static int rd_touch_registry_append(RD_TOUCH_REGISTRY* registry, const RD_TOUCH_REGION* region)
+{
+    if (registry->count == registry->capacity)
+    {
+        int capacity = registry->capacity ? registry->capacity * 2 : 32;
+        RD_TOUCH_REGION* tmp = (RD_TOUCH_REGION*) realloc(registry->regions, capacity * sizeof(RD_TOUCH_REGION));
+        if (!tmp)
+        {
+            fprintf(stderr, "unable to allocate memory\n");
+            return -1;
+        }
+        registry->regions = tmp;
+        registry->capacity = capacity;
+    }
+    registry->regions[registry->count++] = *region;
+    registry->is_indexed = 0;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdTouchRegistryAdd */
+int RdTouchRegistryAdd(RD_INTERFACE* rd_interface, RD_TOUCH_REGISTRY* registry, RD_TOUCH_REGION* region)
+{
+    int ret;
+
+    if (registry == NULL || region == NULL)
+    {
+        fprintf(stderr, "touch registry should not NULL\n");
+        return -070201;
+    }
+    if (region->outer_radius)
+    {
+        ret = Rd_TouchMapCircle(rd_interface, region->position, region->outer_radius, region->inner_radius,
+            region->label, &region->touch_id);
+    }
+    else
+    {
+        ret = Rd_TouchMapRectangle(rd_interface, region->position, region->size, region->label, &region->touch_id);
+    }
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (rd_touch_registry_append(registry, region) < 0)
+    {
+        /* keep device and registry consistent */
+        Rd_TouchMapDelete(rd_interface, region->touch_id);
+        return -070202;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdTouchRegistryAddArray */
+int RdTouchRegistryAddArray(RD_INTERFACE* rd_interface, RD_TOUCH_REGISTRY* registry, RD_TOUCH_REGION* regions, int count)
+{
+    int ret, i;
+    for (i = 0; i < count; i++)
+    {
+        ret = RdTouchRegistryAdd(rd_interface, registry, &regions[i]);
+        if (ret < 0)
+        {
+            return ret;
+        }
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* RdTouchRegistryRemove */
+int RdTouchRegistryRemove(RD_INTERFACE* rd_interface, RD_TOUCH_REGISTRY* registry, RD_ID touch_id)
+{
+    int ret, i;
+
+    if (registry == NULL)
+    {
+        fprintf(stderr, "touch registry should not NULL\n");
+        return -070301;
+    }
+    for (i = 0; i < registry->count; i++)
+    {
+        if (registry->regions[i].touch_id == touch_id)
+        {
+            break;
+        }
+    }
+    if (i == registry->count)
+    {
+        fprintf(stderr, "touch id %d not registered\n", touch_id);
+        return -070302;
+    }
+    ret = Rd_TouchMapDelete(rd_interface, touch_id);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    /* keep registration order, later regions are on top */
+    memmove(&registry->regions[i], &registry->regions[i + 1], (registry->count - i - 1) * sizeof(RD_TOUCH_REGION));
+    registry->count--;
+    registry->is_indexed = 0;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdTouchRegistryClear */
+int RdTouchRegistryClear(RD_INTERFACE* rd_interface, RD_TOUCH_REGISTRY* registry)
+{
+    int ret;
+
+    if (registry == NULL)
+    {
+        fprintf(stderr, "touch registry should not NULL\n");
+        return -070401;
+    }
+    ret = Rd_TouchMapClear(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    registry->count = 0;
+    registry->is_indexed = 0;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdTouchRegistryFind */
+const RD_TOUCH_REGION* RdTouchRegistryFind(RD_TOUCH_REGISTRY* registry, RD_POSITION position)
+{
+    int i, cell;
+
+    if (registry == NULL || position.x >= registry->screen_size.width || position.y >= registry->screen_size.height)
+    {
+        return NULL;
+    }
+    if (!registry->is_indexed && rd_touch_registry_index(registry) < 0)
+    {
+        /* no memory for the index, search all regions */
+        for (i = registry->count - 1; i >= 0; i--)
+        {
+            if (rd_touch_region_contains(&registry->regions[i], position))
+            {
+                return &registry->regions[i];
+            }
+        }
+        return NULL;
+    }
+    /* last registered region on top */
+    cell = (position.y / registry->cell_size.height) * registry->grid_columns + position.x / registry->cell_size.width;
+    for (i = registry->cell_start[cell + 1] - 1; i >= registry->cell_start[cell]; i--)
+    {
+        if (rd_touch_region_contains(&registry->regions[registry->cell_regions[i]], position))
+        {
+            return &registry->regions[registry->cell_regions[i]];
+        }
+    }
+    return NULL;
+}
+
+/* ================================================================== */
+/* RdTouchRegistryFindId */
+const RD_TOUCH_REGION* RdTouchRegistryFindId(RD_TOUCH_REGISTRY* registry, RD_ID touch_id)
+{
+    int low = 0, high, middle;
+    const RD_TOUCH_REGION* region;
+
+    if (registry == NULL)
+    {
+        return NULL;
+    }
+    if (!registry->is_indexed && rd_touch_registry_index(registry) < 0)
+    {
+        for (low = 0; low < registry->count; low++)
+        {
+            if (registry->regions[low].touch_id == touch_id)
+            {
+                return &registry->regions[low];
+            }
+        }
+        return NULL;
+    }
+    high = registry->count - 1;
+    while (low <= high)
+    {
+        middle = (low + high) / 2;
+        region = &registry->regions[registry->by_id[middle * 2 + 1]];
+        if (region->touch_id == touch_id)
+        {
+            return region;
+        }
+        if (region->touch_id < touch_id)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+    return NULL;
+}
+
+/* ================================================================== */
+/* RdTouchRegistryDispatch */
+int RdTouchRegistryDispatch(RD_TOUCH_REGISTRY* registry, RD_ID touch_id)
+{
+    const RD_TOUCH_REGION* region = RdTouchRegistryFindId(registry, touch_id);
+    if (!region || !region->handler)
+    {
+        return 0;
+    }
+    region->handler(region, region->context);
+    return 1;
+}
@@ -0,0 +1,217 @@
+/* ripdraw-tune.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * link tuning: window of commands in flight from measured wire and device time
+ */
+#include "ripdraw.h"
+
+/* weight of the newest reply in the decayed estimates */
+#define RD_TUNE_ALPHA		(1.0 / 16)
+
+long long rd_extint_clock_us(void);
+
+/* ================================================================== */
+/* RdTuneEnable */
+int RdTuneEnable(RD_INTERFACE* rd_interface, int latency_budget_us)
+{
+    _RD_CHECK_INTERFACE();
+
+    if (latency_budget_us > 0 && rd_interface->tune == NULL)
+    {
+        rd_interface->tune = (RD_TUNE*) malloc(sizeof(RD_TUNE));
+        if (!rd_interface->tune)
+        {
+            fprintf(stderr, "unable to allocate memory\n");
+            return -0150101;
+        }
+        memset(rd_interface->tune, 0, sizeof(RD_TUNE));
+        rd_interface->tune->us_per_byte = RD_TUNE_US_PER_BYTE;
+        rd_interface->tune->window = 1;
+    }
+    else if (latency_budget_us <= 0 && rd_interface->tune)
+    {
+        free(rd_interface->tune);
+        rd_interface->tune = NULL;
+        return 0;
+    }
+    if (rd_interface->tune)
+    {
+        rd_interface->tune->latency_us = latency_budget_us;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* estimates of a command id, the slot of the least used command is taken over when all are used */
+static RD_TUNE_COMMAND* rd_tune_command(RD_TUNE* tune, int cmd_id, int create)
+{
+    int i;
+    RD_TUNE_COMMAND* lightest = &tune->commands[0];
+
+    for (i = 0; i < RD_TUNE_SLOTS; i++)
+    {
+        if (tune->commands[i].cmd_id == cmd_id)
+        {
+            return &tune->commands[i];
+        }
+        if (tune->commands[i].weight < lightest->weight)
+        {
+            lightest = &tune->commands[i];
+        }
+    }
+    if (!create)
+    {
+        return NULL;
+    }
+    memset(lightest, 0, sizeof(RD_TUNE_COMMAND));
+    lightest->cmd_id = cmd_id;
+    return lightest;
+}
+
+/* ================================================================== */
+/* time per byte from round trips of equal commands with different lengths */
+static void rd_tune_fit(RD_TUNE* tune)
+{
+    int i;
+    double sxx = 0, sxy = 0;
+
+    for (i = 0; i < RD_TUNE_SLOTS; i++)
+    {
+        sxx += tune->commands[i].sxx;
+        sxy += tune->commands[i].sxy;
+    }
+    /* equal lengths only, the default stays */
+    if (sxx >= 1.0 && sxy > 0)
+    {
+        tune->us_per_byte = sxy / sxx;
+    }
+}
+
+/* ================================================================== */
+/* service time: round trip without wire time */
+static double rd_tune_service(const RD_TUNE* tune, const RD_TUNE_COMMAND* command)
+{
+    double service = command->mean_us - tune->us_per_byte * command->mean_bytes;
+    return (service > 0) ? service : 0;
+}
+
+/* ================================================================== */
+/* commands in flight to keep the link busy, within the latency budget */
+static int rd_tune_window(const RD_TUNE* tune, const RD_TUNE_COMMAND* command, int request_size)
+{
+    double gap, window, limit;
+
+    if (command->weight == 0)
+    {
+        return tune->window;
+    }
+    /* before the first pipelined reply the request on the wire is all a reply has to wait for */
+    gap = command->gap_us;
+    if (gap <= 0)
+    {
+        gap = tune->us_per_byte * request_size;
+    }
+    if (gap < 1)
+    {
+        gap = 1;
+    }
+    window = command->mean_us / gap + 0.999;
+    limit = 1 + (double) tune->latency_us / gap;
+    if (window > limit)
+    {
+        window = limit;
+    }
+    if (window > RD_MAX_PENDING)
+    {
+        window = RD_MAX_PENDING;
+    }
+    return (window < 1) ? 1 : (int) window;
+}
+
+/* ================================================================== */
+/* time the reply just received for the request sent */
+void rd_tune_sample(RD_INTERFACE* rd_interface, const RD_INTERFACE_PENDING* sent)
+{
+    RD_TUNE* tune = rd_interface->tune;
+    RD_TUNE_COMMAND* command;
+    long long now;
+    double bytes, time_us, dx, dy;
+
+    if (tune == NULL)
+    {
+        return;
+    }
+    now = rd_extint_clock_us();
+    command = rd_tune_command(tune, sent->cmd_id, 1);
+    if (sent->sent_us < tune->last_reply_us)
+    {
+        /* sent before the previous reply, it waited behind that command */
+        time_us = (double) (now - tune->last_reply_us);
+        command->gap_us = (command->gap_us > 0) ? command->gap_us + RD_TUNE_ALPHA * (time_us - command->gap_us) : time_us;
+    }
+    else
+    {
+        /* decayed running regression of round trip on bytes */
+        bytes = sent->size + rd_interface->response.size;
+        time_us = (double) (now - sent->sent_us);
+        command->weight = command->weight * (1 - RD_TUNE_ALPHA) + 1;
+        dx = bytes - command->mean_bytes;
+        dy = time_us - command->mean_us;
+        command->mean_bytes += dx / command->weight;
+        command->mean_us += dy / command->weight;
+        command->sxx = command->sxx * (1 - RD_TUNE_ALPHA) + dx * (bytes - command->mean_bytes);
+        command->sxy = command->sxy * (1 - RD_TUNE_ALPHA) + dx * (time_us - command->mean_us);
+        rd_tune_fit(tune);
+    }
+    tune->last_reply_us = now;
+    tune->samples++;
+    tune->window = rd_tune_window(tune, command, sent->size);
+    rd_interface->max_pending = tune->window;
+}
+
+/* ================================================================== */
+/* RdTuneServiceUs */
+double RdTuneServiceUs(RD_INTERFACE* rd_interface, int cmd_id)
+{
+    RD_TUNE_COMMAND* command;
+
+    if (rd_interface == NULL || rd_interface->tune == NULL)
+    {
+        return -1;
+    }
+    command = rd_tune_command(rd_interface->tune, cmd_id, 0);
+    if (command == NULL || command->weight == 0)
+    {
+        return -1;
+    }
+    return rd_tune_service(rd_interface->tune, command);
+}
+
+/* ================================================================== */
+/* RdTuneReport */
+void RdTuneReport(RD_INTERFACE* rd_interface, FILE* file)
+{
+    int i;
+    RD_TUNE* tune;
+    RD_TUNE_COMMAND* command;
+
+    if (rd_interface == NULL || rd_interface->tune == NULL)
+    {
+        return;
+    }
+    tune = rd_interface->tune;
+    fprintf(file, "  link %.0f bytes/s, window %d, %lld replies\n",
+        1000000.0 / tune->us_per_byte, tune->window, tune->samples);
+    for (i = 0; i < RD_TUNE_SLOTS; i++)
+    {
+        command = &tune->commands[i];
+        if (command->cmd_id == 0 || command->weight == 0)
+        {
+            continue;
+        }
+        fprintf(file, "  command 0x%04X: round trip %.0f us, service %.0f us, gap %.0f us\n",
+            command->cmd_id, command->mean_us, rd_tune_service(tune, command), command->gap_us);
+    }
+}
@@ -0,0 +1,111 @@
+/* ripdraw-tx.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * write coalescing: small frames held for a latency budget share one write
+ */
+#include "ripdraw.h"
+
+int rd_extint_write(RD_INTERFACE* rd_interface, RD_BYTE* data_ptr, int data_len);
+long long rd_extint_clock_us(void);
+
+/* ================================================================== */
+/* RdTxCoalesce */
+int RdTxCoalesce(RD_INTERFACE* rd_interface, int budget_us)
+{
+    int previous;
+    RD_TX* tx;
+    _RD_CHECK_INTERFACE();
+
+    tx = &rd_interface->tx;
+    if (budget_us > 0 && tx->buffer.ptr == NULL)
+    {
+        tx->buffer.ptr = (RD_BYTE*) malloc(RD_TX_CAPACITY);
+        if (!tx->buffer.ptr)
+        {
+            fprintf(stderr, "unable to allocate memory\n");
+            return -0170101;
+        }
+        tx->buffer.capacity = RD_TX_CAPACITY;
+        tx->buffer.size = 0;
+    }
+    previous = tx->budget_us;
+    tx->budget_us = (budget_us > 0) ? budget_us : 0;
+    return previous;
+}
+
+/* ================================================================== */
+/* RdTxFlush */
+int RdTxFlush(RD_INTERFACE* rd_interface)
+{
+    int ret;
+    RD_TX* tx;
+    _RD_CHECK_INTERFACE();
+
+    tx = &rd_interface->tx;
+    if (tx->frames == 0)
+    {
+        return 0;
+    }
+    ret = rd_extint_write(rd_interface, tx->buffer.ptr, tx->buffer.size);
+    tx->writes++;
+    tx->frames_written += tx->frames;
+    tx->buffer.size = 0;
+    tx->frames = 0;
+    return ret;
+}
+
+/* ================================================================== */
+/* write held frames when the request of seq_no is one of them */
+int rd_tx_flush_for(RD_INTERFACE* rd_interface, RD_UWORD seq_no)
+{
+    RD_TX* tx = &rd_interface->tx;
+
+    /* held frames are the newest, sequence numbers wrap around */
+    if (tx->frames == 0 || (RD_UWORD) (seq_no - tx->first_seq) >= 0x8000)
+    {
+        return 0;
+    }
+    return RdTxFlush(rd_interface);
+}
+
+/* ================================================================== */
+/* write a frame or hold it, frames keep their order */
+int rd_tx_write(RD_INTERFACE* rd_interface, RD_BYTE* data_ptr, int data_len)
+{
+    int ret;
+    long long now;
+    RD_TX* tx = &rd_interface->tx;
+
+    /* frames held before go first */
+    if (tx->buffer.size + data_len > tx->buffer.capacity || tx->budget_us == 0)
+    {
+        ret = RdTxFlush(rd_interface);
+        if (ret < 0)
+        {
+            return ret;
+        }
+    }
+    if (data_len > tx->buffer.capacity || tx->budget_us == 0)
+    {
+        tx->writes++;
+        tx->frames_written++;
+        return rd_extint_write(rd_interface, data_ptr, data_len);
+    }
+
+    now = rd_extint_clock_us();
+    if (tx->frames == 0)
+    {
+        tx->first_us = now;
+        tx->first_seq = *((RD_UWORD*) (data_ptr + 2));
+    }
+    memcpy(tx->buffer.ptr + tx->buffer.size, data_ptr, data_len);
+    tx->buffer.size += data_len;
+    tx->frames++;
+    if (now - tx->first_us >= tx->budget_us)
+    {
+        return RdTxFlush(rd_interface);
+    }
+    return 0;
+}
@@ -0,0 +1,378 @@
+/* ripdraw-warm.c
+ *
+ * supports Windows/Linux only
+ * supports little-endian CPU only
+ *
+ * warm start: reattach to the screen a previous run left on the device
+ */
+#include "ripdraw.h"
+#include <time.h>
+
+/* label of the sentinel, followed by the nonce of the save */
+#define RD_WARM_SENTINEL_LABEL		"rd-warm-%08x"
+
+RD_RESOURCE* rd_resource_find(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+void rd_resource_unregister(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+void rd_resource_forget(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type);
+
+	/* start of a warm start file, followed by resources and journal entries with their payloads */
+	struct warm_header
+	{
+		char magic[4];
+		unsigned int version;
+		unsigned int fingerprint;		/* scene fingerprint of the application */
+		unsigned int identity;			/* hash of the device version strings */
+		unsigned int sentinel;			/* device id of the sentinel touch region */
+		unsigned int nonce;				/* new on every save, part of the sentinel label */
+		int resource_count;
+		int journal_count;
+	};
+
+/* ================================================================== */
+/* hash of application, hardware and os version of the device */
+static int rd_warm_identity(RD_INTERFACE* rd_interface, unsigned int* identity)
+{
+    int ret, type, length;
+    const char* version;
+
+    *identity = 0;
+    for (type = RD_GET_VERSION_TYPE_DEVAPP; type <= RD_GET_VERSION_TYPE_OS; type++)
+    {
+        ret = Rd_SystemInfoView(rd_interface, (RD_GET_VERSION_TYPE) type, &version, &length);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        *identity = *identity * 31 + RdPackHash((const RD_BYTE*) version, length);
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* the sentinel is removed from the device, the saved file can not be attached to any more */
+void rd_warm_forget(RD_INTERFACE* rd_interface)
+{
+    rd_interface->has_warm_sentinel = 0;
+    if (rd_interface->warm_file[0])
+    {
+        remove(rd_interface->warm_file);
+        rd_interface->warm_file[0] = 0;
+    }
+}
+
+/* ================================================================== */
+/* delete touch region by device id, it is not in the registry */
+static int rd_warm_sentinel_delete(RD_INTERFACE* rd_interface, RD_ID sentinel)
+{
+    int ret, active = 0;
+    int remapped = rd_interface->remapped;
+
+    /* the reply tells whether the sentinel is still there, it is never queued */
+    if (rd_interface->batch)
+    {
+        ret = RdBatchSubmit(rd_interface);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        active = rd_interface->batch->active;
+        rd_interface->batch->active = 0;
+    }
+    rd_interface->remapped = 0;
+    ret = Rd_TouchMapDelete(rd_interface, sentinel);
+    rd_interface->remapped = remapped;
+    if (rd_interface->batch)
+    {
+        rd_interface->batch->active = active;
+    }
+    return ret;
+}
+
+/* ================================================================== */
+/* leave a new sentinel on the device and write the file */
+static int rd_warm_save(RD_INTERFACE* rd_interface, const char* file_name, unsigned int fingerprint, unsigned int identity)
+{
+    int ret, i;
+    RD_ID touch_id;
+    RD_RESOURCE* resource;
+    RD_JOURNAL* journal;
+    struct warm_header header;
+    char label[32];
+    FILE* file;
+
+    if (strlen(file_name) >= RD_WARM_FILE_LENGTH)
+    {
+        fprintf(stderr, "warm start file name too long: %s\n", file_name);
+        return -0140103;
+    }
+    /* one sentinel per device, the one of an earlier save is replaced */
+    if (rd_interface->has_warm_sentinel)
+    {
+        rd_interface->has_warm_sentinel = 0;
+        ret = rd_warm_sentinel_delete(rd_interface, rd_interface->warm_sentinel);
+        if (ret < 0)
+        {
+            return ret;
+        }
+    }
+    /* a region of another run or program never carries the label of this save */
+    memset(&header, 0, sizeof(header));
+    header.nonce = (unsigned int) time(NULL) * 31 + (unsigned int) clock() + identity + (unsigned int) rd_interface->seq_no;
+    sprintf(label, RD_WARM_SENTINEL_LABEL, header.nonce);
+    ret = Rd_TouchMapRectangle(rd_interface, Rd_Position(0, 0), Rd_Size(1, 1), label, &touch_id);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    /* the sentinel belongs to no owner and is never reported as leaked */
+    resource = rd_resource_find(rd_interface, RD_RESOURCE_TOUCH, touch_id);
+    rd_interface->warm_sentinel = resource ? resource->device_id : touch_id;
+    rd_interface->has_warm_sentinel = 1;
+    rd_resource_unregister(rd_interface, RD_RESOURCE_TOUCH, touch_id);
+
+    journal = rd_interface->journal;
+    memcpy(header.magic, RD_WARM_MAGIC, 4);
+    header.version = RD_WARM_VERSION;
+    header.fingerprint = fingerprint;
+    header.identity = identity;
+    header.sentinel = rd_interface->warm_sentinel;
+    header.resource_count = rd_interface->resource_count;
+    header.journal_count = journal ? journal->count : 0;
+
+    file = fopen(file_name, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "unable to create %s\n", file_name);
+        return -0140101;
+    }
+    ret = 0;
+    if (fwrite(&header, sizeof(header), 1, file) != 1
+        || (header.resource_count
+            && fwrite(rd_interface->resources, sizeof(RD_RESOURCE), header.resource_count, file) != (size_t) header.resource_count))
+    {
+        ret = -0140102;
+    }
+    /* payload pointers are written too, they are replaced on load */
+    for (i = 0; i < header.journal_count && ret == 0; i++)
+    {
+        if (fwrite(&journal->entries[i], sizeof(RD_JOURNAL_ENTRY), 1, file) != 1
+            || fwrite(journal->entries[i].payload, journal->entries[i].length, 1, file) != 1)
+        {
+            ret = -0140102;
+        }
+    }
+    if (fclose(file) != 0 && ret == 0)
+    {
+        ret = -0140102;
+    }
+    if (ret < 0)
+    {
+        fprintf(stderr, "unable to write %s\n", file_name);
+        remove(file_name);
+        return ret;
+    }
+    strcpy(rd_interface->warm_file, file_name);
+    rd_interface->warm_serial = rd_interface->resource_serial;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdWarmFingerprint */
+unsigned int RdWarmFingerprint(unsigned int fingerprint, const void* data, int length)
+{
+    const RD_BYTE* bytes = (const RD_BYTE*) data;
+    int i;
+    for (i = 0; i < length; i++)
+    {
+        fingerprint = (fingerprint ^ bytes[i]) * 16777619u;
+    }
+    return fingerprint;
+}
+
+/* ================================================================== */
+/* RdWarmStartSave */
+int RdWarmStartSave(RD_INTERFACE* rd_interface, const char* file_name, unsigned int fingerprint)
+{
+    int ret;
+    unsigned int identity;
+
+    _RD_CHECK_INTERFACE();
+
+    ret = rd_warm_identity(rd_interface, &identity);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_warm_save(rd_interface, file_name, fingerprint, identity);
+}
+
+/* ================================================================== */
+/* read resources and journal entries following the header, 0 when the file is incomplete */
+static int rd_warm_read(FILE* file, const struct warm_header* header, RD_RESOURCE** resources, RD_JOURNAL_ENTRY** entries)
+{
+    int i, count = 0;
+    RD_JOURNAL_ENTRY* entry;
+
+    *resources = (RD_RESOURCE*) malloc(header->resource_count * sizeof(RD_RESOURCE) + 1);
+    *entries = (RD_JOURNAL_ENTRY*) malloc(header->journal_count * sizeof(RD_JOURNAL_ENTRY) + 1);
+    if (!*resources || !*entries
+        || (header->resource_count
+            && fread(*resources, sizeof(RD_RESOURCE), header->resource_count, file) != (size_t) header->resource_count))
+    {
+        count = -1;
+    }
+    for (i = 0; i < header->journal_count && count == i; i++)
+    {
+        entry = &(*entries)[i];
+        if (fread(entry, sizeof(RD_JOURNAL_ENTRY), 1, file) != 1
+            || entry->length < 0 || entry->id_count < 0 || entry->id_count > RD_JOURNAL_MAX_IDS)
+        {
+            break;
+        }
+        entry->payload = (RD_BYTE*) malloc(entry->length + 1);
+        if (!entry->payload)
+        {
+            break;
+        }
+        count++;
+        if (fread(entry->payload, entry->length, 1, file) != 1 && entry->length)
+        {
+            break;
+        }
+    }
+    if (count == header->journal_count)
+    {
+        return 1;
+    }
+    for (i = 0; i < count; i++)
+    {
+        free((*entries)[i].payload);
+    }
+    RdFreeData(*resources);
+    RdFreeData(*entries);
+    return 0;
+}
+
+/* ================================================================== */
+/* RdWarmStartAttach */
+int RdWarmStartAttach(RD_INTERFACE* rd_interface, const char* file_name, unsigned int fingerprint)
+{
+    int ret, i, match;
+    unsigned int identity;
+    struct warm_header header;
+    RD_RESOURCE* resources;
+    RD_JOURNAL_ENTRY* entries;
+    RD_JOURNAL* journal;
+    FILE* file;
+
+    _RD_CHECK_INTERFACE();
+
+    /* no saved scene, cold start */
+    file = fopen(file_name, "rb");
+    if (!file)
+    {
+        return 0;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, RD_WARM_MAGIC, 4) != 0
+        || header.version != RD_WARM_VERSION || header.fingerprint != fingerprint
+        || header.resource_count < 0 || header.journal_count < 0
+        || !rd_warm_read(file, &header, &resources, &entries))
+    {
+        /* written by another version or for another scene */
+        fclose(file);
+        remove(file_name);
+        return 0;
+    }
+    fclose(file);
+#ifdef RD_NO_HEAP
+    /* the registry keeps the room taken when the interface was opened */
+    if (header.resource_count > rd_interface->resource_capacity)
+    {
+        fprintf(stderr, "more than %d resources\n", RD_NO_HEAP_RESOURCES);
+        for (i = 0; i < header.journal_count; i++)
+        {
+            free(entries[i].payload);
+        }
+        RdFreeData(resources);
+        RdFreeData(entries);
+        return -0140301;
+    }
+#endif
+
+    /* same device with the same firmware, and the sentinel is still there */
+    ret = rd_warm_identity(rd_interface, &identity);
+    match = (ret == 0 && identity == header.identity);
+    if (match)
+    {
+        ret = rd_warm_sentinel_delete(rd_interface, (RD_ID) header.sentinel);
+        /* a refused delete only means the device lost its state */
+        match = (ret == 0);
+        ret = (ret < 0 && rd_interface->last_response_status == 0) ? ret : 0;
+    }
+    if (!match)
+    {
+        for (i = 0; i < header.journal_count; i++)
+        {
+            free(entries[i].payload);
+        }
+        RdFreeData(resources);
+        RdFreeData(entries);
+        /* the scene is gone, the file must not match a later device state
+           it is kept when the link failed and the state is unknown */
+        if (ret == 0)
+        {
+            remove(file_name);
+        }
+        return ret;
+    }
+
+    /* take over registry and journal of the previous run */
+    rd_resource_forget(rd_interface, RD_RESOURCE_ALL);
+#ifdef RD_NO_HEAP
+    memcpy(rd_interface->resources, resources, header.resource_count * sizeof(RD_RESOURCE));
+    RdFreeData(resources);
+    resources = rd_interface->resources;
+#else
+    RdFreeData(rd_interface->resources);
+    rd_interface->resources = resources;
+    rd_interface->resource_capacity = header.resource_count;
+#endif
+    rd_interface->resource_count = header.resource_count;
+    rd_interface->remapped = 0;
+    for (i = 0; i < header.resource_count; i++)
+    {
+        if (resources[i].device_id != resources[i].id)
+        {
+            rd_interface->remapped = 1;
+        }
+        /* serials handed out later stay new */
+        if (resources[i].serial > rd_interface->resource_serial)
+        {
+            rd_interface->resource_serial = resources[i].serial;
+        }
+    }
+    journal = rd_interface->journal;
+    if (journal)
+    {
+        RdFreeData(journal->entries);
+        journal->entries = entries;
+        journal->count = header.journal_count;
+        journal->capacity = header.journal_count;
+    }
+    else
+    {
+        for (i = 0; i < header.journal_count; i++)
+        {
+            free(entries[i].payload);
+        }
+        RdFreeData(entries);
+    }
+
+    /* the probe deleted the sentinel, leave a new one for the next run */
+    ret = rd_warm_save(rd_interface, file_name, fingerprint, identity);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return 1;
+}
@@ -11,11 +11,36 @@
 #define RD_PROTO_POS_PL				4
 #define RD_PROTO_POS_BYTE_0			6
 #define RD_PROTO_POS_BYTE_1			8
+/* data of a reply carrying status, data length and data */
+#define RD_PROTO_POS_DATA			10
 
 int rd_extint_open(RD_INTERFACE* rd_interface, const char* port_name);
 int rd_extint_close(RD_INTERFACE* rd_interface);
 int rd_extint_write(RD_INTERFACE* rd_interface, RD_BYTE* data_ptr, int data_len);
 int rd_extint_read(RD_INTERFACE* rd_interface, RD_BYTE* data_ptr, int data_len);
+int rd_broadcast_write(RD_INTERFACE* rd_interface);
+int rd_broadcast_receive(RD_INTERFACE* rd_interface, int expected_cmd_id, RD_UWORD expected_seq_no);
+int rd_resource_register(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID device_id, RD_ID* id);
+RD_ID rd_resource_device_id(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+int rd_journal_record(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+int rd_journal_update(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+long long rd_extint_clock_us(void);
+void rd_tune_sample(RD_INTERFACE* rd_interface, const RD_INTERFACE_PENDING* sent);
+void rd_flow_release(RD_INTERFACE* rd_interface, const RD_INTERFACE_PENDING* sent, int result);
+int rd_cmd_response_drain(RD_INTERFACE* rd_interface);
+int rd_cmd_response_receive_oldest(RD_INTERFACE* rd_interface);
+int rd_tx_write(RD_INTERFACE* rd_interface, RD_BYTE* data_ptr, int data_len);
+int rd_tx_flush_for(RD_INTERFACE* rd_interface, RD_UWORD seq_no);
+RD_LAYER_STATE* rd_state_layer(RD_INTERFACE* rd_interface, RD_ID layer_id);
+int rd_batch_defers(RD_INTERFACE* rd_interface, int cmd_id);
+int rd_batch_queue(RD_INTERFACE* rd_interface);
+int rd_batch_submit_before(RD_INTERFACE* rd_interface, int cmd_id);
+void rd_prefetch_complete(RD_INTERFACE* rd_interface);
+int rd_cmd_request_send(RD_INTERFACE* rd_interface);
+void rd_resource_unregister(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id);
+void rd_resource_forget(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type);
+void rd_warm_forget(RD_INTERFACE* rd_interface);
+void rd_resource_report_leaks(RD_INTERFACE* rd_interface);
 
 /* ================================================================== */
 /* calculate the checksum */
@@ -45,7 +70,17 @@ int rd_buffer_check_and_allocate(RD_INTERFACE_BUFFER* buffer, int required_capac
     {
         return 0;
     }
+#ifdef RD_NO_HEAP
+    /* largest frame is taken when the interface is opened, it never grows */
+    if (buffer->ptr || required_capacity > RD_MAX_FRAME)
+    {
+        fprintf(stderr, "frame larger than %d bytes\n", RD_MAX_FRAME);
+        return -010203;
+    }
+    required_capacity = RD_MAX_FRAME;
+#else
     required_capacity = (required_capacity < 32) ? 32 : required_capacity;
+#endif
     tmp = (RD_BYTE*) malloc(required_capacity);
     if (!tmp)
     {
@@ -95,6 +130,24 @@ int rd_cmd_request_append_uword(RD_INTERFACE* rd_interface, RD_UWORD input)
     return 0;
 }
 
+/* ================================================================== */
+/* append id of a device resource, translated to the device id after a reconnect */
+int rd_cmd_request_append_id(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, RD_ID id)
+{
+    RD_JOURNAL_ID* journal_id;
+    _RD_CHECK_INTERFACE();
+
+    /* journal keeps the client id, it is translated again on replay */
+    if (rd_interface->journal && rd_interface->request_id_count < RD_JOURNAL_MAX_IDS)
+    {
+        journal_id = &rd_interface->request_ids[rd_interface->request_id_count++];
+        journal_id->offset = rd_interface->request.size - RD_PROTO_POS_BYTE_0;
+        journal_id->type = type;
+        journal_id->id = id;
+    }
+    return rd_cmd_request_append_uword(rd_interface, rd_interface->remapped ? rd_resource_device_id(rd_interface, type, id) : id);
+}
+
 /* ================================================================== */
 /* append flag parameter to request */
 int rd_cmd_request_append_flag(RD_INTERFACE* rd_interface, RD_FLAG input)
@@ -143,11 +196,10 @@ int rd_cmd_request_append_direction(RD_INTERFACE* rd_interface, RD_DIRECTION inp
 }
 
 /* ================================================================== */
-/* append string parameter to request */
-int rd_cmd_request_append_string(RD_INTERFACE* rd_interface, const char* input)
+/* append length prefixed data parameter to request */
+int rd_cmd_request_append_data(RD_INTERFACE* rd_interface, const char* input, int len)
 {
     int ret;
-    int len = strlen(input);
     ret = rd_cmd_request_append_uword(rd_interface, len);
     if (ret < 0)
     {
@@ -163,6 +215,13 @@ int rd_cmd_request_append_string(RD_INTERFACE* rd_interface, const char* input)
     return 0;
 }
 
+/* ================================================================== */
+/* append string parameter to request */
+int rd_cmd_request_append_string(RD_INTERFACE* rd_interface, const char* input)
+{
+    return rd_cmd_request_append_data(rd_interface, input, strlen(input));
+}
+
 /* ================================================================== */
 /* get uword from response at given byte position */
 int rd_cmd_response_check_and_get_uword(RD_INTERFACE* rd_interface, int byte_position, RD_UWORD* output)
@@ -180,6 +239,26 @@ int rd_cmd_response_check_and_get_uword(RD_INTERFACE* rd_interface, int byte_pos
     return 0;
 }
 
+/* ================================================================== */
+/* get id of a new device resource from response and register it */
+int rd_cmd_response_check_and_get_id(RD_INTERFACE* rd_interface, RD_RESOURCE_TYPE type, int byte_position, RD_ID* output)
+{
+    int ret;
+    RD_ID device_id;
+    ret = rd_cmd_response_check_and_get_uword(rd_interface, byte_position, &device_id);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    /* client gets a different id than the device only after a reconnect */
+    ret = rd_resource_register(rd_interface, type, device_id, output);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_journal_record(rd_interface, type, *output);
+}
+
 /* ================================================================== */
 /* get byte from response at given byte position */
 int rd_cmd_response_check_and_get_byte(RD_INTERFACE* rd_interface, int byte_position, RD_BYTE* output)
@@ -198,49 +277,75 @@ int rd_cmd_response_check_and_get_byte(RD_INTERFACE* rd_interface, int byte_posi
 }
 
 /* ================================================================== */
-/* get data from response at given byte position */
-/* it is up to the user to free allocated memory */
-int rd_cmd_response_check_and_get_data(RD_INTERFACE* rd_interface, int byte_position, char** output)
+/* get data from response at given byte position without copying */
+/* data stays valid until the next command of the interface, its length is the word before it */
+int rd_cmd_response_check_and_get_view(RD_INTERFACE* rd_interface, int byte_position, const char** data, int* length)
 {
     int ret;
-    int check_bytes;
-    RD_UWORD length;
-	char* tmp;
+    RD_UWORD data_length;
 
     _RD_CHECK_INTERFACE();
 
-    ret = rd_cmd_response_check_and_get_uword(rd_interface, byte_position - 2, &length);
+    ret = rd_cmd_response_check_and_get_uword(rd_interface, byte_position - 2, &data_length);
     if (ret < 0)
     {
         return ret;
     }
-    check_bytes = byte_position + length;
-    if (rd_interface->response.ptr == NULL || (rd_interface->response.size < check_bytes))
+    if (rd_interface->response.ptr == NULL || (rd_interface->response.size < byte_position + data_length))
     {
         fprintf(stderr, "invalid response received\n");
         return -011201;
     }
+    *data = (const char*) rd_interface->response.ptr + byte_position;
+    *length = data_length;
+    return 0;
+}
+
+/* ================================================================== */
+/* copy data into buffer of the caller, terminated */
+int rd_data_copy(const char* data, int length, char* buffer, int buffer_size)
+{
+    if (buffer == NULL || length >= buffer_size)
+    {
+        fprintf(stderr, "buffer too small for %d bytes\n", length);
+        return -011701;
+    }
+    memcpy(buffer, data, length);
+    buffer[length] = 0;
+    return 0;
+}
+
+#ifndef RD_NO_HEAP
+/* ================================================================== */
+/* copy data into allocated memory, terminated */
+/* it is up to the user to free allocated memory */
+int rd_data_allocate(const char* data, int length, char** output)
+{
+    char* tmp;
+
     *output = NULL;
-    tmp = (char*) malloc(length);
+    /* terminated, version strings can be used as they are */
+    tmp = (char*) malloc(length + 1);
     if (!tmp)
     {
         fprintf(stderr, "unable to allocate memory\n");
-        return -011202;
+        return -012001;
     }
-    memcpy(tmp, rd_interface->response.ptr + byte_position, length);
+    memcpy(tmp, data, length);
+    tmp[length] = 0;
     *output = tmp;
     return 0;
 }
+#endif
 
 /* ================================================================== */
-/* get event data from buffer */
-/* it is up to the user to free allocated memory */
-int rd_cmd_response_check_and_get_event_data(RD_INTERFACE* rd_interface, RD_EVENT** event, int byte_position, RD_UWORD* count)
+/* get events from response without copying, data of events points into the response */
+int rd_cmd_response_check_and_get_event_view(RD_INTERFACE* rd_interface, RD_EVENT* event, int capacity,
+int byte_position, RD_UWORD* count)
 {
     int ret;
     int check_bytes;
 	RD_UWORD packet_count = 0;
-	RD_EVENT* temp_event;
 	int i;
 
     _RD_CHECK_INTERFACE();
@@ -262,13 +367,12 @@ int rd_cmd_response_check_and_get_event_data(RD_INTERFACE* rd_interface, RD_EVEN
         }
         byte_position += 2;
 
-       temp_event = (RD_EVENT*) malloc(packet_count * sizeof(RD_EVENT));
-        if (!temp_event)
+        if (event == NULL || packet_count > capacity)
         {
-            fprintf(stderr, "unable to allocate memory\n");
+            fprintf(stderr, "no room for %d events\n", packet_count);
             return -011301;
         }
-        memset(temp_event, 0, sizeof(RD_EVENT) * packet_count);
+        memset(event, 0, sizeof(RD_EVENT) * packet_count);
 
         for (i = 0; i < packet_count; i++)
         {
@@ -281,7 +385,7 @@ int rd_cmd_response_check_and_get_event_data(RD_INTERFACE* rd_interface, RD_EVEN
             byte_position += 2;
             length = length - 1;
 
-            ret = rd_cmd_response_check_and_get_byte(rd_interface, byte_position, &temp_event[i].event_type);
+            ret = rd_cmd_response_check_and_get_byte(rd_interface, byte_position, &event[i].event_type);
             if (ret < 0)
             {
                 return ret;
@@ -294,24 +398,69 @@ int rd_cmd_response_check_and_get_event_data(RD_INTERFACE* rd_interface, RD_EVEN
                 fprintf(stderr, "invalid response received\n");
                 return -011302;
             }
-
-            temp_event[i].data = (RD_BYTE*) malloc(length);
-            if (!temp_event[i].data)
-            {
-                fprintf(stderr, "unable to allocate memory\n");
-                return -011303;
-            }
-            memcpy(temp_event[i].data, rd_interface->response.ptr + byte_position, length);
+            event[i].data = rd_interface->response.ptr + byte_position;
             byte_position += length;
 
-            temp_event[i].has_more_data = has_more_data;
+            event[i].has_more_data = has_more_data;
         }
-        *event = temp_event;
     }
     *count = packet_count;
     return 0;
 }
 
+#ifndef RD_NO_HEAP
+/* ================================================================== */
+/* get event data from buffer */
+/* it is up to the user to free allocated memory */
+int rd_cmd_response_check_and_get_event_data(RD_INTERFACE* rd_interface, RD_EVENT** event, int byte_position, RD_UWORD* count)
+{
+    int ret;
+	RD_UWORD packet_count = 0;
+	RD_EVENT* temp_event;
+	int i, length;
+
+    ret = rd_cmd_response_check_and_get_uword(rd_interface, byte_position, &packet_count);
+    if (ret < 0 || packet_count == 0)
+    {
+        *count = 0;
+        return ret;
+    }
+    temp_event = (RD_EVENT*) malloc(packet_count * sizeof(RD_EVENT));
+    if (!temp_event)
+    {
+        fprintf(stderr, "unable to allocate memory\n");
+        return -011303;
+    }
+    ret = rd_cmd_response_check_and_get_event_view(rd_interface, temp_event, packet_count, byte_position, count);
+    if (ret < 0)
+    {
+        free(temp_event);
+        return ret;
+    }
+
+    for (i = 0; i < packet_count; i++)
+    {
+        const RD_BYTE* data = temp_event[i].data;
+        /* length field before the event type counts the type too */
+        length = (RD_UWORD) (*((const RD_UWORD*) (data - 3)) - 1);
+        temp_event[i].data = (RD_BYTE*) malloc(length + 1);
+        if (!temp_event[i].data)
+        {
+            while (i-- > 0)
+            {
+                free(temp_event[i].data);
+            }
+            free(temp_event);
+            fprintf(stderr, "unable to allocate memory\n");
+            return -011303;
+        }
+        memcpy(temp_event[i].data, data, length);
+    }
+    *event = temp_event;
+    return 0;
+}
+#endif
+
 /* ================================================================== */
 /* initialize new request */
 int rd_cmd_request_init(RD_INTERFACE* rd_interface, RD_COMMAND_IDS cmd_id)
@@ -319,8 +468,29 @@ int rd_cmd_request_init(RD_INTERFACE* rd_interface, RD_COMMAND_IDS cmd_id)
     int ret;
     _RD_CHECK_INTERFACE();
 
+    /* replies of split commands in flight arrive first */
+    if (rd_interface->async_phase == RD_ASYNC_NONE && rd_interface->async_flush)
+    {
+        rd_interface->async_flush(rd_interface->async_context);
+    }
+    /* loads prefetched are answered before this command */
+    if (rd_interface->async_phase != RD_ASYNC_COMPLETE)
+    {
+        rd_prefetch_complete(rd_interface);
+    }
+    /* queued commands go first unless the command does not depend on them */
+    ret = rd_batch_submit_before(rd_interface, cmd_id);
+    if (ret < 0)
+    {
+        return ret;
+    }
     rd_interface->request.size = 0;
-    rd_interface->response.size = 0;
+    rd_interface->request_id_count = 0;
+    /* reply of a split command is received before it is encoded again */
+    if (rd_interface->async_phase != RD_ASYNC_COMPLETE)
+    {
+        rd_interface->response.size = 0;
+    }
     /* add command id */
 	rd_interface->last_cmd_id = cmd_id;
     ret = rd_cmd_request_append_uword(rd_interface, (RD_UWORD) cmd_id);
@@ -329,8 +499,15 @@ int rd_cmd_request_init(RD_INTERFACE* rd_interface, RD_COMMAND_IDS cmd_id)
         return ret;
     }
     /* add sequence number */  
-	rd_interface->seq_no++;
-    ret = rd_cmd_request_append_uword(rd_interface, rd_interface->seq_no);
+    if (rd_interface->async_phase == RD_ASYNC_COMPLETE)
+    {
+        ret = rd_cmd_request_append_uword(rd_interface, rd_interface->async_ticket.seq_no);
+    }
+    else
+    {
+        rd_interface->seq_no++;
+        ret = rd_cmd_request_append_uword(rd_interface, rd_interface->seq_no);
+    }
 	if (ret < 0)
     {
         return ret;
@@ -339,15 +516,61 @@ int rd_cmd_request_init(RD_INTERFACE* rd_interface, RD_COMMAND_IDS cmd_id)
     return rd_cmd_request_append_uword(rd_interface, 0);
 }
 
+/* ================================================================== */
+/* wait for the oldest replies until the request fits the flow budget */
+int rd_flow_acquire(RD_INTERFACE* rd_interface, int size)
+{
+    int ret;
+    long long start = 0;
+    RD_FLOW* flow = &rd_interface->flow;
+
+    while (flow->budget > 0 && flow->in_flight > 0 && flow->in_flight_bytes + size > flow->budget)
+    {
+        if (rd_interface->pending_count == 0)
+        {
+            /* only split commands in flight, replies are collected by their event loop
+               another split command is refused, a direct command can not wait and goes over budget */
+            if (rd_interface->async_phase == RD_ASYNC_SEND)
+            {
+                flow->blocked++;
+                return RD_FLOW_BLOCKED;
+            }
+            break;
+        }
+        if (start == 0)
+        {
+            start = rd_extint_clock_us();
+            flow->stalls++;
+        }
+        ret = rd_cmd_response_receive_oldest(rd_interface);
+        if (ret < 0)
+        {
+            rd_cmd_response_drain(rd_interface);
+            flow->stalled_us += rd_extint_clock_us() - start;
+            return ret;
+        }
+    }
+    if (start)
+    {
+        flow->stalled_us += rd_extint_clock_us() - start;
+    }
+    return 0;
+}
+
 /* ================================================================== */
 /* send command to device */
 int rd_cmd_request_process(RD_INTERFACE* rd_interface)
 {
-    int ret, i;
+    int ret;
     RD_UWORD payload_len;
     RD_UWORD checksum;
     _RD_CHECK_INTERFACE();
 
+    if (rd_interface->request.size - RD_PROTO_POS_BYTE_0 > RD_MAX_PAYLOAD)
+    {
+        fprintf(stderr, "payload too large: %d\n", rd_interface->request.size - RD_PROTO_POS_BYTE_0);
+        return -011501;
+    }
     payload_len = rd_interface->request.size - RD_PROTO_POS_BYTE_0;
     /* update data length */
     *((RD_UWORD*) (rd_interface->request.ptr + RD_PROTO_POS_PL)) = payload_len;
@@ -359,6 +582,25 @@ int rd_cmd_request_process(RD_INTERFACE* rd_interface)
         return ret;
     }
 
+    /* sent already, only encoded again to complete it */
+    if (rd_interface->async_phase == RD_ASYNC_COMPLETE)
+    {
+        return 0;
+    }
+    /* sent with the batch */
+    if (rd_batch_defers(rd_interface, rd_interface->last_cmd_id))
+    {
+        return rd_batch_queue(rd_interface);
+    }
+    return rd_cmd_request_send(rd_interface);
+}
+
+/* ================================================================== */
+/* write encoded request to device */
+int rd_cmd_request_send(RD_INTERFACE* rd_interface)
+{
+    int ret, i;
+
 	if (rd_interface->verbose >= 2)
 	{
 		printf("write: %d\n", rd_interface->request.size);
@@ -368,15 +610,37 @@ int rd_cmd_request_process(RD_INTERFACE* rd_interface)
 		}
 		printf("\n");
 	}
+    ret = rd_flow_acquire(rd_interface, rd_interface->request.size);
+    if (ret < 0)
+    {
+        return ret;
+    }
     /* send to device */
-	ret = rd_extint_write(rd_interface, rd_interface->request.ptr, rd_interface->request.size);
+    if (rd_interface->broadcast)
+    {
+        ret = rd_broadcast_write(rd_interface);
+    }
+    else
+    {
+        ret = rd_tx_write(rd_interface, rd_interface->request.ptr, rd_interface->request.size);
+    }
 	RD_DBG(3, "write: %d done\n", ret);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_interface->flow.in_flight++;
+    rd_interface->flow.in_flight_bytes += rd_interface->request.size;
+    rd_interface->sent.cmd_id = *((RD_UWORD*) (rd_interface->request.ptr + RD_PROTO_POS_CMD));
+    rd_interface->sent.seq_no = *((RD_UWORD*) (rd_interface->request.ptr + RD_PROTO_POS_SEQ));
+    rd_interface->sent.sent_us = rd_extint_clock_us();
+    rd_interface->sent.size = rd_interface->request.size;
 	return ret;
 }
 
 /* ================================================================== */
-/* receive command response */
-int rd_cmd_response_receive(RD_INTERFACE* rd_interface)
+/* receive response of given command and sequence number */
+int rd_cmd_response_receive_seq(RD_INTERFACE* rd_interface, int expected_cmd_id, RD_UWORD expected_seq_no)
 {
     int ret, i, retry_count;
 	RD_ID cmd_id;
@@ -386,6 +650,17 @@ int rd_cmd_response_receive(RD_INTERFACE* rd_interface)
     RD_UWORD response_checksum;
     _RD_CHECK_INTERFACE();
 
+    if (rd_interface->broadcast)
+    {
+        return rd_broadcast_receive(rd_interface, expected_cmd_id, expected_seq_no);
+    }
+    /* the request may still be held */
+    ret = rd_tx_flush_for(rd_interface, expected_seq_no);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
     ret = rd_buffer_check_and_allocate(&rd_interface->response, 16);
     if (ret < 0)
     {
@@ -396,15 +671,15 @@ int rd_cmd_response_receive(RD_INTERFACE* rd_interface)
 	retry_count = 0;
 retry:
 
-	/* sleep to give time device for processing */
-	RD_SLEEP(3);
-    /* read command id and check with last id */
+    /* read command id and check with last id, reads block until the device answers */
 	if (retry_count == 0)
 	{
 		ret = rd_extint_read(rd_interface, rd_interface->response.ptr, 2);
 	}
 	else
 	{
+		/* give the device time before looking for the reply in the next byte */
+		RD_SLEEP(3);
 		/* remove first byte and read next byte */
 		rd_interface->response.ptr[0] = rd_interface->response.ptr[1];
 		ret = rd_extint_read(rd_interface, rd_interface->response.ptr + 1, 1);
@@ -428,7 +703,7 @@ retry:
     {
         return ret;
     }
-	if (rd_interface->last_cmd_id != cmd_id)
+	if (expected_cmd_id != cmd_id)
 	{
 		if (retry_count > 2000)
 		{
@@ -462,9 +737,9 @@ retry:
     {
         return ret;
     }
-	if (rd_interface->seq_no != seq_no)
+	if (expected_seq_no != seq_no)
 	{
-		fprintf(stderr, "sequence number not match %d != %d\n", rd_interface->seq_no, seq_no);
+		fprintf(stderr, "sequence number not match %d != %d\n", expected_seq_no, seq_no);
 		return -011602;
 	}
     /* extract payload length */
@@ -522,6 +797,308 @@ retry:
     return 0;
 }
 
+/* ================================================================== */
+/* receive response of a sent request, its credits are returned even when it failed */
+int rd_cmd_response_receive_sent(RD_INTERFACE* rd_interface, const RD_INTERFACE_PENDING* sent)
+{
+    int ret;
+
+    ret = rd_cmd_response_receive_seq(rd_interface, sent->cmd_id, sent->seq_no);
+    rd_flow_release(rd_interface, sent, ret);
+    if (ret == 0)
+    {
+        rd_tune_sample(rd_interface, sent);
+    }
+    return ret;
+}
+
+/* ================================================================== */
+/* receive responses of all sub-commands still in flight
+   returns the first error, but always reads every pending response */
+int rd_cmd_response_drain(RD_INTERFACE* rd_interface)
+{
+    int ret = 0, i, tmp;
+    _RD_CHECK_INTERFACE();
+
+    for (i = 0; i < rd_interface->pending_count; i++)
+    {
+        tmp = rd_cmd_response_receive_sent(rd_interface, &rd_interface->pending[i]);
+        if (tmp < 0 && ret == 0)
+        {
+            ret = tmp;
+        }
+    }
+    rd_interface->pending_count = 0;
+    return ret;
+}
+
+/* ================================================================== */
+/* receive response of the oldest sub-command in flight */
+int rd_cmd_response_receive_oldest(RD_INTERFACE* rd_interface)
+{
+    int ret;
+
+    ret = rd_cmd_response_receive_sent(rd_interface, &rd_interface->pending[0]);
+    rd_interface->pending_count--;
+    memmove(rd_interface->pending, rd_interface->pending + 1, rd_interface->pending_count * sizeof(RD_INTERFACE_PENDING));
+    return ret;
+}
+
+/* ================================================================== */
+/* keep response of last sent sub-command in flight
+   waits for the oldest response once max_pending commands are in flight */
+int rd_cmd_response_defer(RD_INTERFACE* rd_interface)
+{
+    int ret, max_pending;
+    _RD_CHECK_INTERFACE();
+
+    if (rd_interface->batch && rd_interface->batch->queued)
+    {
+        rd_interface->batch->queued = 0;
+        return 0;
+    }
+    max_pending = rd_interface->max_pending;
+    if (max_pending > RD_MAX_PENDING)
+    {
+        max_pending = RD_MAX_PENDING;
+    }
+    rd_interface->pending[rd_interface->pending_count] = rd_interface->sent;
+    rd_interface->pending_count++;
+    if (rd_interface->pending_count < max_pending)
+    {
+        return 0;
+    }
+    ret = rd_cmd_response_receive_oldest(rd_interface);
+    if (ret < 0)
+    {
+        rd_cmd_response_drain(rd_interface);
+    }
+    return ret;
+}
+
+/* ================================================================== */
+/* receive command response */
+int rd_cmd_response_receive(RD_INTERFACE* rd_interface)
+{
+    int ret;
+    _RD_CHECK_INTERFACE();
+
+    /* queued in a batch, the reply arrives when it is sent */
+    if (rd_interface->batch && rd_interface->batch->queued)
+    {
+        rd_interface->batch->queued = 0;
+        return 0;
+    }
+
+    ret = rd_cmd_response_drain(rd_interface);
+    if (ret < 0)
+    {
+        /* the request was sent, its reply is read so that its credits come back */
+        if (rd_interface->async_phase != RD_ASYNC_COMPLETE)
+        {
+            rd_cmd_response_receive_sent(rd_interface, &rd_interface->sent);
+        }
+        return ret;
+    }
+    if (rd_interface->async_phase == RD_ASYNC_SEND)
+    {
+        /* reply is collected later by RdAsyncReceive */
+        rd_interface->async_ticket = rd_interface->sent;
+        return RD_ASYNC_SENT;
+    }
+    if (rd_interface->async_phase == RD_ASYNC_COMPLETE)
+    {
+        return 0;
+    }
+    return rd_cmd_response_receive_sent(rd_interface, &rd_interface->sent);
+}
+
+/* ================================================================== */
+/* RdAsyncPhase */
+void RdAsyncPhase(RD_INTERFACE* rd_interface, RD_ASYNC_PHASE phase, const RD_INTERFACE_PENDING* ticket)
+{
+    if (rd_interface == NULL)
+    {
+        return;
+    }
+    rd_interface->async_phase = phase;
+    if (ticket)
+    {
+        rd_interface->async_ticket = *ticket;
+    }
+}
+
+/* ================================================================== */
+/* RdAsyncReceive */
+int RdAsyncReceive(RD_INTERFACE* rd_interface, const RD_INTERFACE_PENDING* ticket)
+{
+    if (rd_interface == NULL || ticket == NULL)
+    {
+        fprintf(stderr, "rd_interface should not NULL\n");
+        return -012201;
+    }
+    return rd_cmd_response_receive_sent(rd_interface, ticket);
+}
+
+/* ================================================================== */
+/* RdAsyncWindowInit */
+void RdAsyncWindowInit(RD_INTERFACE* rd_interface, RD_ASYNC_WINDOW* window, RD_ASYNC_COMMAND command,
+RD_ASYNC_DONE done, void* context)
+{
+    memset(window, 0, sizeof(RD_ASYNC_WINDOW));
+    window->command = command;
+    window->done = done;
+    window->context = context;
+    window->size = 1;
+    if (rd_interface == NULL)
+    {
+        return;
+    }
+    window->size = rd_interface->max_pending;
+    window->size = (window->size > RD_MAX_PENDING) ? RD_MAX_PENDING : (window->size < 1) ? 1 : window->size;
+    window->direct = rd_interface->async_phase != RD_ASYNC_NONE || rd_interface->broadcast
+        || (rd_interface->batch && rd_interface->batch->active);
+    /* replies of split commands sent before arrive first */
+    if (!window->direct && rd_interface->async_flush)
+    {
+        rd_interface->async_flush(rd_interface->async_context);
+    }
+}
+
+/* ================================================================== */
+/* RdAsyncWindowTrySend */
+int RdAsyncWindowTrySend(RD_INTERFACE* rd_interface, RD_ASYNC_WINDOW* window, int item)
+{
+    int ret, slot;
+    _RD_CHECK_INTERFACE();
+
+    if (window->direct)
+    {
+        ret = window->command(rd_interface, window->context, item);
+        if (window->done)
+        {
+            window->done(rd_interface, window->context, item, ret);
+        }
+        return 0;
+    }
+    if (window->count >= window->size)
+    {
+        return RD_FLOW_BLOCKED;
+    }
+    RdAsyncPhase(rd_interface, RD_ASYNC_SEND, NULL);
+    ret = window->command(rd_interface, window->context, item);
+    RdAsyncPhase(rd_interface, RD_ASYNC_NONE, NULL);
+    if (ret != RD_ASYNC_SENT)
+    {
+        /* nothing had to be sent */
+        if (ret == 0 && window->done)
+        {
+            window->done(rd_interface, window->context, item, 0);
+        }
+        return ret;
+    }
+    slot = (window->first + window->count) % RD_MAX_PENDING;
+    window->items[slot] = item;
+    window->tickets[slot] = rd_interface->async_ticket;
+    window->count++;
+    return 0;
+}
+
+/* ================================================================== */
+/* RdAsyncWindowSend */
+int RdAsyncWindowSend(RD_INTERFACE* rd_interface, RD_ASYNC_WINDOW* window, int item)
+{
+    int ret;
+
+    for (;;)
+    {
+        ret = RdAsyncWindowTrySend(rd_interface, window, item);
+        /* the oldest reply makes room in the window or returns flow credits */
+        if (ret != RD_FLOW_BLOCKED || window->count == 0)
+        {
+            return ret;
+        }
+        RdAsyncWindowComplete(rd_interface, window);
+    }
+}
+
+/* ================================================================== */
+/* RdAsyncWindowComplete */
+int RdAsyncWindowComplete(RD_INTERFACE* rd_interface, RD_ASYNC_WINDOW* window)
+{
+    int ret, item;
+    RD_INTERFACE_PENDING ticket;
+    _RD_CHECK_INTERFACE();
+
+    if (window->count == 0)
+    {
+        return 0;
+    }
+    /* taken off first, the command may send other commands completing the window */
+    item = window->items[window->first];
+    ticket = window->tickets[window->first];
+    window->first = (window->first + 1) % RD_MAX_PENDING;
+    window->count--;
+    ret = RdAsyncReceive(rd_interface, &ticket);
+    if (ret == 0)
+    {
+        RdAsyncPhase(rd_interface, RD_ASYNC_COMPLETE, &ticket);
+        ret = window->command(rd_interface, window->context, item);
+        RdAsyncPhase(rd_interface, RD_ASYNC_NONE, NULL);
+    }
+    if (window->done)
+    {
+        window->done(rd_interface, window->context, item, ret);
+    }
+    return ret;
+}
+
+/* ================================================================== */
+/* RdAsyncWindowDrain */
+int RdAsyncWindowDrain(RD_INTERFACE* rd_interface, RD_ASYNC_WINDOW* window)
+{
+    int ret = 0, tmp;
+
+    while (window->count > 0)
+    {
+        tmp = RdAsyncWindowComplete(rd_interface, window);
+        if (ret == 0)
+        {
+            ret = tmp;
+        }
+    }
+    return ret;
+}
+
+/* ================================================================== */
+/* take the memory the command path needs up front, nothing to do unless RD_NO_HEAP is defined */
+int rd_interface_reserve(RD_INTERFACE* rd_interface)
+{
+#ifdef RD_NO_HEAP
+    int ret;
+    ret = rd_buffer_check_and_allocate(&rd_interface->request, RD_MAX_FRAME);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    ret = rd_buffer_check_and_allocate(&rd_interface->response, RD_MAX_FRAME);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_interface->resources = (RD_RESOURCE*) malloc(RD_NO_HEAP_RESOURCES * sizeof(RD_RESOURCE));
+    if (!rd_interface->resources)
+    {
+        fprintf(stderr, "unable to allocate memory\n");
+        return -012101;
+    }
+    rd_interface->resource_capacity = RD_NO_HEAP_RESOURCES;
+#else
+    (void) rd_interface;
+#endif
+    return 0;
+}
+
 /* ================================================================== */
 /* RdInterfaceInit */
 RD_INTERFACE* RdInterfaceInit(const char* port_name)
@@ -542,6 +1119,11 @@ RD_INTERFACE* RdInterfaceInit(const char* port_name)
 
     /* prepare interface */
     rd_interface->is_open = 1;
+    if (rd_interface_reserve(rd_interface) < 0)
+    {
+        RdInterfaceClose(rd_interface);
+        return NULL;
+    }
 
     return rd_interface;
 }
@@ -560,8 +1142,35 @@ int RdInterfaceClose(RD_INTERFACE* rd_interface)
     {
         free(rd_interface->response.ptr);
     }
+    RdFreeData(rd_interface->tx.buffer.ptr);
+    if (rd_interface->batch)
+    {
+        /* commands still queued are never sent */
+        RdFreeData(rd_interface->batch->entries);
+        RdFreeData(rd_interface->batch->frames.ptr);
+        free(rd_interface->batch);
+    }
+    if (rd_interface->prefetch)
+    {
+        RdFreeData(rd_interface->prefetch->entries);
+        free(rd_interface->prefetch);
+    }
+
+    /* resources still on the device were never released */
+    rd_resource_report_leaks(rd_interface);
+    RdFreeData(rd_interface->resources);
+    RdJournalEnable(rd_interface, 0);
+    RdTuneEnable(rd_interface, 0);
 
-    rd_extint_close(rd_interface);
+    if (rd_interface->broadcast)
+    {
+        /* members stay open, they are closed by their owner */
+        free(rd_interface->broadcast);
+    }
+    else
+    {
+        rd_extint_close(rd_interface);
+    }
     free(rd_interface);
     return 0;
 }
@@ -583,6 +1192,19 @@ int RdFreeData(void* data)
 int Rd_SetLayerEnable(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_FLAG enable)
 {
     int ret;
+    RD_LAYER_STATE* layer = rd_state_layer(rd_interface, layer_id);
+
+    if (layer)
+    {
+        /* already in effect */
+        if ((layer->known & RD_STATE_ENABLE) && layer->enable == enable)
+        {
+            rd_interface->state.elided++;
+            return 0;
+        }
+        /* unknown until the device accepted it */
+        layer->known &= ~RD_STATE_ENABLE;
+    }
 
 	//RD_DBG(1, "Rd_SetLayerEnable layer_id: %d enable: %d\n", layer_id, enable);
     ret = rd_cmd_request_init(rd_interface, Cmd_SetLayerEnable);
@@ -605,7 +1227,17 @@ int Rd_SetLayerEnable(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_FLAG enable
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (layer)
+    {
+        layer->enable = enable;
+        layer->known |= RD_STATE_ENABLE;
+    }
+    return rd_journal_update(rd_interface, RD_RESOURCE_ALL, layer_id);
 }
 
 /* ================================================================== */
@@ -614,6 +1246,21 @@ int Rd_SetLayerOriginAndSize(RD_INTERFACE* rd_interface, RD_ID layer_id,
 RD_POSITION position, RD_SIZE size)
 {
     int ret;
+    RD_LAYER_STATE* layer = rd_state_layer(rd_interface, layer_id);
+
+    if (layer)
+    {
+        /* already in effect */
+        if ((layer->known & RD_STATE_ORIGIN_SIZE)
+            && layer->position.x == position.x && layer->position.y == position.y
+            && layer->size.width == size.width && layer->size.height == size.height)
+        {
+            rd_interface->state.elided++;
+            return 0;
+        }
+        /* unknown until the device accepted it */
+        layer->known &= ~RD_STATE_ORIGIN_SIZE;
+    }
 
 	//RD_DBG(1, "Rd_SetLayerOriginAndSize layer_id: %d position: %dx%d, size: %dx%d\n", layer_id, position.x, position.y, size.width, size.height);
     ret = rd_cmd_request_init(rd_interface, Cmd_SetLayerOriginAndSize);
@@ -651,7 +1298,18 @@ RD_POSITION position, RD_SIZE size)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (layer)
+    {
+        layer->position = position;
+        layer->size = size;
+        layer->known |= RD_STATE_ORIGIN_SIZE;
+    }
+    return rd_journal_update(rd_interface, RD_RESOURCE_ALL, layer_id);
 }
 
 /* ================================================================== */
@@ -659,6 +1317,21 @@ RD_POSITION position, RD_SIZE size)
 int Rd_SetLayerBackColor(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_COLOR back_color)
 {
     int ret;
+    RD_LAYER_STATE* layer = rd_state_layer(rd_interface, layer_id);
+
+    if (layer)
+    {
+        /* already in effect */
+        if ((layer->known & RD_STATE_BACK_COLOR)
+            && layer->back_color.red == back_color.red && layer->back_color.green == back_color.green
+            && layer->back_color.blue == back_color.blue && layer->back_color.alpha == back_color.alpha)
+        {
+            rd_interface->state.elided++;
+            return 0;
+        }
+        /* unknown until the device accepted it */
+        layer->known &= ~RD_STATE_BACK_COLOR;
+    }
 
 	//RD_DBG(1, "Rd_SetLayerBackColor layer_id: %d color: %02X %02X %02X %02X\n", layer_id, back_color.red, back_color.green, back_color.blue, back_color.alpha);
     ret = rd_cmd_request_init(rd_interface, Cmd_SetLayerBackColor);
@@ -681,7 +1354,17 @@ int Rd_SetLayerBackColor(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_COLOR ba
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (layer)
+    {
+        layer->back_color = back_color;
+        layer->known |= RD_STATE_BACK_COLOR;
+    }
+    return rd_journal_update(rd_interface, RD_RESOURCE_ALL, layer_id);
 }
 
 /* ================================================================== */
@@ -689,6 +1372,19 @@ int Rd_SetLayerBackColor(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_COLOR ba
 int Rd_SetLayerTransparency(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_BYTE transparency_percentage)
 {
     int ret;
+    RD_LAYER_STATE* layer = rd_state_layer(rd_interface, layer_id);
+
+    if (layer)
+    {
+        /* already in effect */
+        if ((layer->known & RD_STATE_TRANSPARENCY) && layer->transparency == transparency_percentage)
+        {
+            rd_interface->state.elided++;
+            return 0;
+        }
+        /* unknown until the device accepted it */
+        layer->known &= ~RD_STATE_TRANSPARENCY;
+    }
     ret = rd_cmd_request_init(rd_interface, Cmd_SetLayerTransparency);
     if (ret < 0)
     {
@@ -709,7 +1405,17 @@ int Rd_SetLayerTransparency(RD_INTERFACE* rd_interface, RD_ID layer_id, RD_BYTE
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (layer)
+    {
+        layer->transparency = transparency_percentage;
+        layer->known |= RD_STATE_TRANSPARENCY;
+    }
+    return rd_journal_update(rd_interface, RD_RESOURCE_ALL, layer_id);
 }
 
 /* ================================================================== */
@@ -741,6 +1447,7 @@ int Rd_LayerMove(RD_INTERFACE* rd_interface, RD_ID layer_id,
 RD_UWORD move_left, RD_UWORD move_top, RD_UWORD move_right, RD_UWORD move_bottom)
 {
     int ret;
+    RD_LAYER_STATE* layer;
     ret = rd_cmd_request_init(rd_interface, Cmd_LayerMove);
     if (ret < 0)
     {
@@ -771,6 +1478,12 @@ RD_UWORD move_left, RD_UWORD move_top, RD_UWORD move_right, RD_UWORD move_bottom
     {
         return ret;
     }
+    /* moved relative to an origin the cache may not know */
+    layer = rd_state_layer(rd_interface, layer_id);
+    if (layer)
+    {
+        layer->known &= ~RD_STATE_ORIGIN_SIZE;
+    }
     ret = rd_cmd_request_process(rd_interface);
     if (ret < 0)
     {
@@ -780,12 +1493,13 @@ RD_UWORD move_left, RD_UWORD move_top, RD_UWORD move_right, RD_UWORD move_bottom
 }
 
 /* ================================================================== */
-/* Rd_LayerWriteRawPixels */
-int Rd_LayerWriteRawPixels(RD_INTERFACE* rd_interface, RD_ID layer_id,
-RD_POSITION position, RD_SIZE pixel_size, const RD_COLOR* pixels)
+/* send one Rd_LayerWriteRawPixels sub-command for a rectangle of pixels
+   rows of the rectangle are stride pixels apart in the source */
+int rd_layer_write_raw_pixels_rect(RD_INTERFACE* rd_interface, RD_ID layer_id,
+RD_POSITION position, RD_SIZE pixel_size, const RD_COLOR* pixels, int stride)
 {
     int ret;
-    int pixels_len_in_bytes, pixel_len;
+    int row_len_in_bytes, pixel_len, row;
     ret = rd_cmd_request_init(rd_interface, Cmd_LayerWriteRawPixels);
     if (ret < 0)
     {
@@ -822,21 +1536,81 @@ RD_POSITION position, RD_SIZE pixel_size, const RD_COLOR* pixels)
     {
         return ret;
     }
-    pixels_len_in_bytes = pixel_size.height * pixel_size.width * sizeof(RD_COLOR);
-    ret = rd_buffer_check_and_allocate(&rd_interface->request, rd_interface->request.size + pixels_len_in_bytes);
+    row_len_in_bytes = pixel_size.width * sizeof(RD_COLOR);
+    ret = rd_buffer_check_and_allocate(&rd_interface->request, rd_interface->request.size + pixel_len * sizeof(RD_COLOR));
     if (ret < 0)
     {
         return ret;
     }
-    memcpy(rd_interface->request.ptr + rd_interface->request.size, pixels, pixels_len_in_bytes);
-    rd_interface->request.size += pixels_len_in_bytes;
+    if (stride == pixel_size.width)
+    {
+        memcpy(rd_interface->request.ptr + rd_interface->request.size, pixels, pixel_len * sizeof(RD_COLOR));
+        rd_interface->request.size += pixel_len * sizeof(RD_COLOR);
+    }
+    else
+    {
+        for (row = 0; row < pixel_size.height; row++)
+        {
+            memcpy(rd_interface->request.ptr + rd_interface->request.size, pixels + row * stride, row_len_in_bytes);
+            rd_interface->request.size += row_len_in_bytes;
+        }
+    }
+    return rd_cmd_request_process(rd_interface);
+}
 
-    ret = rd_cmd_request_process(rd_interface);
-    if (ret < 0)
+/* ================================================================== */
+/* write a rectangle of pixels whose rows are stride pixels apart */
+int rd_layer_write_raw_pixels_stride(RD_INTERFACE* rd_interface, RD_ID layer_id,
+RD_POSITION position, RD_SIZE pixel_size, const RD_COLOR* pixels, int stride)
+{
+    int ret;
+    int max_pixels, tile_width, tile_height, x, y;
+    RD_SIZE tile;
+
+    /* layer id, position, size and pixel length precede the pixels */
+    max_pixels = (RD_MAX_PAYLOAD - 6 * 2) / sizeof(RD_COLOR);
+    if (pixel_size.height * pixel_size.width <= max_pixels)
     {
-        return ret;
+        ret = rd_layer_write_raw_pixels_rect(rd_interface, layer_id, position, pixel_size, pixels, stride);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        return rd_cmd_response_receive(rd_interface);
     }
-    return rd_cmd_response_receive(rd_interface);
+
+    /* split into bands of whole rows, very wide rows are split into segments too */
+    tile_width = (pixel_size.width < max_pixels) ? pixel_size.width : max_pixels;
+    tile_height = max_pixels / tile_width;
+    for (y = 0; y < pixel_size.height; y += tile_height)
+    {
+        for (x = 0; x < pixel_size.width; x += tile_width)
+        {
+            tile.width = (pixel_size.width - x < tile_width) ? pixel_size.width - x : tile_width;
+            tile.height = (pixel_size.height - y < tile_height) ? pixel_size.height - y : tile_height;
+            ret = rd_layer_write_raw_pixels_rect(rd_interface, layer_id, Rd_Position(position.x + x, position.y + y),
+                tile, pixels + y * stride + x, stride);
+            if (ret < 0)
+            {
+                rd_cmd_response_drain(rd_interface);
+                return ret;
+            }
+            ret = rd_cmd_response_defer(rd_interface);
+            if (ret < 0)
+            {
+                return ret;
+            }
+        }
+    }
+    return rd_cmd_response_drain(rd_interface);
+}
+
+/* ================================================================== */
+/* Rd_LayerWriteRawPixels */
+int Rd_LayerWriteRawPixels(RD_INTERFACE* rd_interface, RD_ID layer_id,
+RD_POSITION position, RD_SIZE pixel_size, const RD_COLOR* pixels)
+{
+    return rd_layer_write_raw_pixels_stride(rd_interface, layer_id, position, pixel_size, pixels, pixel_size.width);
 }
 
 /* ================================================================== */
@@ -859,7 +1633,12 @@ int Rd_ComposeLayersToPage(RD_INTERFACE* rd_interface, RD_ID page_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_journal_update(rd_interface, RD_RESOURCE_ALL, page_id);
 }
 
 /* ================================================================== */
@@ -933,7 +1712,7 @@ int Rd_ImageLoad(RD_INTERFACE* rd_interface, const char* image_label, RD_ID* ima
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, image_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_IMAGE, RD_PROTO_POS_BYTE_1, image_id);
 }
 
 /* ================================================================== */
@@ -946,7 +1725,7 @@ int Rd_ImageRelease(RD_INTERFACE* rd_interface, RD_ID image_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, image_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_IMAGE, image_id);
     if (ret < 0)
     {
         return ret;
@@ -956,7 +1735,13 @@ int Rd_ImageRelease(RD_INTERFACE* rd_interface, RD_ID image_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_IMAGE, image_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -975,7 +1760,7 @@ RD_POSITION position, RD_ID* image_write_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, image_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_IMAGE, image_id);
     if (ret < 0)
     {
         return ret;
@@ -1000,7 +1785,7 @@ RD_POSITION position, RD_ID* image_write_id)
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, image_write_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_IMAGE_WRITE, RD_PROTO_POS_BYTE_1, image_write_id);
 }
 
 /* ================================================================== */
@@ -1013,7 +1798,7 @@ int Rd_ImageDelete(RD_INTERFACE* rd_interface, RD_ID image_write_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, image_write_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_IMAGE_WRITE, image_write_id);
     if (ret < 0)
     {
         return ret;
@@ -1023,7 +1808,13 @@ int Rd_ImageDelete(RD_INTERFACE* rd_interface, RD_ID image_write_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_IMAGE_WRITE, image_write_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -1036,7 +1827,7 @@ int Rd_ImageMove(RD_INTERFACE* rd_interface, RD_ID image_write_id, RD_POSITION p
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, image_write_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_IMAGE_WRITE, image_write_id);
     if (ret < 0)
     {
         return ret;
@@ -1056,7 +1847,12 @@ int Rd_ImageMove(RD_INTERFACE* rd_interface, RD_ID image_write_id, RD_POSITION p
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_journal_update(rd_interface, RD_RESOURCE_IMAGE_WRITE, image_write_id);
 }
 
 /* ================================================================== */
@@ -1101,7 +1897,7 @@ RD_UWORD index_count, RD_ID* image_list_id)
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, image_list_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_IMAGE_LIST, RD_PROTO_POS_BYTE_1, image_list_id);
 }
 
 /* ================================================================== */
@@ -1114,7 +1910,7 @@ int Rd_ImageListRelease(RD_INTERFACE* rd_interface, RD_ID image_list_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, image_list_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_IMAGE_LIST, image_list_id);
     if (ret < 0)
     {
         return ret;
@@ -1124,7 +1920,13 @@ int Rd_ImageListRelease(RD_INTERFACE* rd_interface, RD_ID image_list_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_IMAGE_LIST, image_list_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -1153,7 +1955,7 @@ RD_ID image_list_id, RD_UWORD image_index, RD_ID* image_list_write_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, image_list_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_IMAGE_LIST, image_list_id);
     if (ret < 0)
     {
         return ret;
@@ -1173,7 +1975,7 @@ RD_ID image_list_id, RD_UWORD image_index, RD_ID* image_list_write_id)
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, image_list_write_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_IMAGE_LIST_WRITE, RD_PROTO_POS_BYTE_1, image_list_write_id);
 }
 
 /* ================================================================== */
@@ -1186,7 +1988,7 @@ int Rd_ImageListReplace(RD_INTERFACE* rd_interface, RD_ID image_list_write_id, R
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, image_list_write_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_IMAGE_LIST_WRITE, image_list_write_id);
     if (ret < 0)
     {
         return ret;
@@ -1201,7 +2003,12 @@ int Rd_ImageListReplace(RD_INTERFACE* rd_interface, RD_ID image_list_write_id, R
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_journal_update(rd_interface, RD_RESOURCE_IMAGE_LIST_WRITE, image_list_write_id);
 }
 
 /* ================================================================== */
@@ -1214,7 +2021,7 @@ int Rd_ImageListDelete(RD_INTERFACE* rd_interface, RD_ID image_list_write_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, image_list_write_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_IMAGE_LIST_WRITE, image_list_write_id);
     if (ret < 0)
     {
         return ret;
@@ -1224,7 +2031,13 @@ int Rd_ImageListDelete(RD_INTERFACE* rd_interface, RD_ID image_list_write_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_IMAGE_LIST_WRITE, image_list_write_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -1253,7 +2066,7 @@ RD_ID image_list_id, RD_UWORD frequency, RD_ID* animation_play_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, image_list_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_IMAGE_LIST, image_list_id);
     if (ret < 0)
     {
         return ret;
@@ -1273,7 +2086,7 @@ RD_ID image_list_id, RD_UWORD frequency, RD_ID* animation_play_id)
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, animation_play_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_ANIMATION, RD_PROTO_POS_BYTE_1, animation_play_id);
 }
 
 /* ================================================================== */
@@ -1286,7 +2099,7 @@ int Rd_AnimationStop(RD_INTERFACE* rd_interface, RD_ID animation_play_id, RD_UWO
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, animation_play_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_ANIMATION, animation_play_id);
     if (ret < 0)
     {
         return ret;
@@ -1314,7 +2127,7 @@ int Rd_AnimationContinue(RD_INTERFACE* rd_interface, RD_ID animation_play_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, animation_play_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_ANIMATION, animation_play_id);
     if (ret < 0)
     {
         return ret;
@@ -1337,7 +2150,7 @@ int Rd_AnimationDelete(RD_INTERFACE* rd_interface, RD_ID animation_play_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, animation_play_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_ANIMATION, animation_play_id);
     if (ret < 0)
     {
         return ret;
@@ -1347,7 +2160,13 @@ int Rd_AnimationDelete(RD_INTERFACE* rd_interface, RD_ID animation_play_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_ANIMATION, animation_play_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -1375,7 +2194,7 @@ int Rd_FontLoad(RD_INTERFACE* rd_interface, const char* font_label, RD_UWORD* fo
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, font_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_FONT, RD_PROTO_POS_BYTE_1, font_id);
 }
 
 /* ================================================================== */
@@ -1388,7 +2207,7 @@ int Rd_FontRelease(RD_INTERFACE* rd_interface, RD_ID font_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, font_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_FONT, font_id);
     if (ret < 0)
     {
         return ret;
@@ -1398,7 +2217,13 @@ int Rd_FontRelease(RD_INTERFACE* rd_interface, RD_ID font_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_FONT, font_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -1411,7 +2236,7 @@ int Rd_SetFontPadding(RD_INTERFACE* rd_interface, RD_ID font_id, const RD_BYTE p
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, font_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_FONT, font_id);
     if (ret < 0)
     {
         return ret;
@@ -1426,7 +2251,12 @@ int Rd_SetFontPadding(RD_INTERFACE* rd_interface, RD_ID font_id, const RD_BYTE p
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_journal_update(rd_interface, RD_RESOURCE_FONT, font_id);
 }
 
 /* ================================================================== */
@@ -1455,7 +2285,7 @@ RD_ID font_id, RD_COLOR color, RD_HDIRECTION hdirection, const char* data, RD_ID
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, font_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_FONT, font_id);
     if (ret < 0)
     {
         return ret;
@@ -1485,7 +2315,7 @@ RD_ID font_id, RD_COLOR color, RD_HDIRECTION hdirection, const char* data, RD_ID
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, string_write_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_STRING_WRITE, RD_PROTO_POS_BYTE_1, string_write_id);
 }
 
 /* ================================================================== */
@@ -1498,7 +2328,7 @@ int Rd_StringReplace(RD_INTERFACE* rd_interface, RD_ID string_write_id, const ch
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, string_write_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_STRING_WRITE, string_write_id);
     if (ret < 0)
     {
         return ret;
@@ -1508,12 +2338,17 @@ int Rd_StringReplace(RD_INTERFACE* rd_interface, RD_ID string_write_id, const ch
     {
         return ret;
     }
-    ret = rd_cmd_request_process(rd_interface);
+    ret = rd_cmd_request_process(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    ret = rd_cmd_response_receive(rd_interface);
     if (ret < 0)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    return rd_journal_update(rd_interface, RD_RESOURCE_STRING_WRITE, string_write_id);
 }
 
 /* ================================================================== */
@@ -1526,7 +2361,7 @@ int Rd_StringDelete(RD_INTERFACE* rd_interface, RD_ID string_write_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, string_write_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_STRING_WRITE, string_write_id);
     if (ret < 0)
     {
         return ret;
@@ -1536,7 +2371,13 @@ int Rd_StringDelete(RD_INTERFACE* rd_interface, RD_ID string_write_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_STRING_WRITE, string_write_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -1565,7 +2406,7 @@ RD_ID font_id, RD_COLOR color, RD_BYTE c, RD_ID* character_write_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, font_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_FONT, font_id);
     if (ret < 0)
     {
         return ret;
@@ -1590,7 +2431,7 @@ RD_ID font_id, RD_COLOR color, RD_BYTE c, RD_ID* character_write_id)
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, character_write_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_CHARACTER_WRITE, RD_PROTO_POS_BYTE_1, character_write_id);
 }
 
 /* ================================================================== */
@@ -1603,7 +2444,7 @@ int Rd_CharacterReplace(RD_INTERFACE* rd_interface, RD_ID character_write_id, RD
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, character_write_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_CHARACTER_WRITE, character_write_id);
     if (ret < 0)
     {
         return ret;
@@ -1618,7 +2459,12 @@ int Rd_CharacterReplace(RD_INTERFACE* rd_interface, RD_ID character_write_id, RD
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_journal_update(rd_interface, RD_RESOURCE_CHARACTER_WRITE, character_write_id);
 }
 
 /* ================================================================== */
@@ -1631,7 +2477,7 @@ int Rd_CharacterDelete(RD_INTERFACE* rd_interface, RD_ID character_write_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, character_write_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_CHARACTER_WRITE, character_write_id);
     if (ret < 0)
     {
         return ret;
@@ -1641,7 +2487,13 @@ int Rd_CharacterDelete(RD_INTERFACE* rd_interface, RD_ID character_write_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_CHARACTER_WRITE, character_write_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -1680,7 +2532,7 @@ RD_SIZE size, RD_ID font_id, RD_COLOR fontcolor, RD_HDIRECTION scroll_direction,
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, font_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_FONT, font_id);
     if (ret < 0)
     {
         return ret;
@@ -1705,7 +2557,7 @@ RD_SIZE size, RD_ID font_id, RD_COLOR fontcolor, RD_HDIRECTION scroll_direction,
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, text_window_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_TEXT_WINDOW, RD_PROTO_POS_BYTE_1, text_window_id);
 }
 
 /* ================================================================== */
@@ -1718,7 +2570,7 @@ int Rd_TextWindowSetInsertionPoint(RD_INTERFACE* rd_interface, RD_ID text_window
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, text_window_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_TEXT_WINDOW, text_window_id);
     if (ret < 0)
     {
         return ret;
@@ -1751,7 +2603,7 @@ int Rd_TextWindowInsertText(RD_INTERFACE* rd_interface, RD_ID text_window_id, co
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, text_window_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_TEXT_WINDOW, text_window_id);
     if (ret < 0)
     {
         return ret;
@@ -1779,7 +2631,7 @@ int Rd_TextWindowDelete(RD_INTERFACE* rd_interface, RD_ID text_window_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, text_window_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_TEXT_WINDOW, text_window_id);
     if (ret < 0)
     {
         return ret;
@@ -1789,7 +2641,13 @@ int Rd_TextWindowDelete(RD_INTERFACE* rd_interface, RD_ID text_window_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_TEXT_WINDOW, text_window_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -1853,7 +2711,7 @@ RD_SIZE size, RD_BYTE line_width, RD_BYTE line_glow_width, RD_FLAG autocompose,
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, graph_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_LINE_GRAPH, RD_PROTO_POS_BYTE_1, graph_id);
 }
 
 /* ================================================================== */
@@ -1862,42 +2720,62 @@ int Rd_LineGraphInsertPoints(RD_INTERFACE* rd_interface, RD_ID graph_id, RD_COLO
 RD_UWORD point_length, const RD_POSITION* points)
 {
     int ret;
-    int points_len_in_bytes;
-    ret = rd_cmd_request_init(rd_interface, Cmd_LineGraphInsertPoints);
-    if (ret < 0)
-    {
-        return ret;
-    }
-    ret = rd_cmd_request_append_uword(rd_interface, graph_id);
-    if (ret < 0)
-    {
-        return ret;
-    }
-    ret = rd_cmd_request_append_color(rd_interface, point_color);
-    if (ret < 0)
-    {
-        return ret;
-    }
-    ret = rd_cmd_request_append_uword(rd_interface, point_length);
-    if (ret < 0)
-    {
-        return ret;
-    }
-    points_len_in_bytes = point_length * sizeof(RD_COLOR);
-    ret = rd_buffer_check_and_allocate(&rd_interface->request, rd_interface->request.size + points_len_in_bytes);
-    if (ret < 0)
-    {
-        return ret;
-    }
-    memcpy(rd_interface->request.ptr + rd_interface->request.size, points, points_len_in_bytes);
-    rd_interface->request.size += points_len_in_bytes;
+    int points_len_in_bytes, max_points, chunk_length, sent;
 
-    ret = rd_cmd_request_process(rd_interface);
-    if (ret < 0)
+    /* graph id, color and point length precede the points */
+    max_points = (RD_MAX_PAYLOAD - 2 - 4 - 2) / sizeof(RD_POSITION);
+    sent = 0;
+    do
     {
-        return ret;
+        chunk_length = (point_length - sent < max_points) ? point_length - sent : max_points;
+        ret = rd_cmd_request_init(rd_interface, Cmd_LineGraphInsertPoints);
+        if (ret < 0)
+        {
+            break;
+        }
+        ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_LINE_GRAPH, graph_id);
+        if (ret < 0)
+        {
+            break;
+        }
+        ret = rd_cmd_request_append_color(rd_interface, point_color);
+        if (ret < 0)
+        {
+            break;
+        }
+        ret = rd_cmd_request_append_uword(rd_interface, chunk_length);
+        if (ret < 0)
+        {
+            break;
+        }
+        points_len_in_bytes = chunk_length * sizeof(RD_POSITION);
+        ret = rd_buffer_check_and_allocate(&rd_interface->request, rd_interface->request.size + points_len_in_bytes);
+        if (ret < 0)
+        {
+            break;
+        }
+        memcpy(rd_interface->request.ptr + rd_interface->request.size, points + sent, points_len_in_bytes);
+        rd_interface->request.size += points_len_in_bytes;
+
+        ret = rd_cmd_request_process(rd_interface);
+        if (ret < 0)
+        {
+            break;
+        }
+        sent += chunk_length;
+        if (sent >= point_length)
+        {
+            return rd_cmd_response_receive(rd_interface);
+        }
+        ret = rd_cmd_response_defer(rd_interface);
+        if (ret < 0)
+        {
+            return ret;
+        }
     }
-    return rd_cmd_response_receive(rd_interface);
+    while (sent < point_length);
+    rd_cmd_response_drain(rd_interface);
+    return ret;
 }
 
 /* ================================================================== */
@@ -1911,7 +2789,7 @@ RD_UWORD left, RD_UWORD top, RD_UWORD right, RD_UWORD bottom)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, graph_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_LINE_GRAPH, graph_id);
     if (ret < 0)
     {
         return ret;
@@ -1954,7 +2832,7 @@ int Rd_LineGraphDeleteWindow(RD_INTERFACE* rd_interface, RD_ID graph_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, graph_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_LINE_GRAPH, graph_id);
     if (ret < 0)
     {
         return ret;
@@ -1964,7 +2842,13 @@ int Rd_LineGraphDeleteWindow(RD_INTERFACE* rd_interface, RD_ID graph_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_LINE_GRAPH, graph_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -2028,7 +2912,7 @@ RD_BYTE stack_size, RD_DIRECTION stack_direction, RD_FLAG autocompose, RD_ID* gr
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, graph_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_BAR_GRAPH, RD_PROTO_POS_BYTE_1, graph_id);
 }
 
 /* ================================================================== */
@@ -2041,7 +2925,7 @@ int Rd_BarGraphInsertStacks(RD_INTERFACE* rd_interface, RD_ID graph_id, RD_BYTE
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, graph_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_BAR_GRAPH, graph_id);
     if (ret < 0)
     {
         return ret;
@@ -2051,7 +2935,7 @@ int Rd_BarGraphInsertStacks(RD_INTERFACE* rd_interface, RD_ID graph_id, RD_BYTE
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, image_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_IMAGE, image_id);
     if (ret < 0)
     {
         return ret;
@@ -2074,7 +2958,7 @@ int Rd_BarGraphRemoveStacks(RD_INTERFACE* rd_interface, RD_ID graph_id, RD_BYTE
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, graph_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_BAR_GRAPH, graph_id);
     if (ret < 0)
     {
         return ret;
@@ -2102,7 +2986,7 @@ int Rd_BarGraphDeleteWindow(RD_INTERFACE* rd_interface, RD_ID graph_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, graph_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_BAR_GRAPH, graph_id);
     if (ret < 0)
     {
         return ret;
@@ -2112,7 +2996,13 @@ int Rd_BarGraphDeleteWindow(RD_INTERFACE* rd_interface, RD_ID graph_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_BAR_GRAPH, graph_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -2160,7 +3050,7 @@ int Rd_TouchMapRectangle(RD_INTERFACE* rd_interface, RD_POSITION position, RD_SI
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, touch_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_TOUCH, RD_PROTO_POS_BYTE_1, touch_id);
 }
 
 /* ================================================================== */
@@ -2209,7 +3099,7 @@ RD_UWORD outer_circle_radius, RD_UWORD inner_circle_radius, const char* label, R
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, touch_id);
+    return rd_cmd_response_check_and_get_id(rd_interface, RD_RESOURCE_TOUCH, RD_PROTO_POS_BYTE_1, touch_id);
 }
 
 /* ================================================================== */
@@ -2222,7 +3112,7 @@ int Rd_TouchMapDelete(RD_INTERFACE* rd_interface, RD_ID touch_id)
     {
         return ret;
     }
-    ret = rd_cmd_request_append_uword(rd_interface, touch_id);
+    ret = rd_cmd_request_append_id(rd_interface, RD_RESOURCE_TOUCH, touch_id);
     if (ret < 0)
     {
         return ret;
@@ -2232,7 +3122,13 @@ int Rd_TouchMapDelete(RD_INTERFACE* rd_interface, RD_ID touch_id)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_resource_unregister(rd_interface, RD_RESOURCE_TOUCH, touch_id);
+    return 0;
 }
 
 /* ================================================================== */
@@ -2245,12 +3141,21 @@ int Rd_TouchMapClear(RD_INTERFACE* rd_interface)
     {
         return ret;
     }
+    /* the warm start sentinel is a touch region too */
+    rd_warm_forget(rd_interface);
     ret = rd_cmd_request_process(rd_interface);
     if (ret < 0)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    /* all touch maps are gone */
+    rd_resource_forget(rd_interface, RD_RESOURCE_TOUCH);
+    return 0;
 }
 
 /* ================================================================== */
@@ -2263,17 +3168,28 @@ int Rd_Reset(RD_INTERFACE* rd_interface)
     {
         return ret;
     }
+    /* the warm start sentinel goes with the reset, even when no reply arrives */
+    rd_warm_forget(rd_interface);
+    /* device settings are back to their defaults, whatever the reply is */
+    RdStateCacheForget(rd_interface);
     ret = rd_cmd_request_process(rd_interface);
     if (ret < 0)
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    /* device forgets all resources */
+    rd_resource_forget(rd_interface, RD_RESOURCE_ALL);
+    return 0;
 }
 
 /* ================================================================== */
-/* Rd_TestEcho */
-int Rd_TestEcho(RD_INTERFACE* rd_interface, const char* label, char** output)
+/* send test echo and wait for the reply */
+static int rd_test_echo_request(RD_INTERFACE* rd_interface, const char* label)
 {
     int ret;
     ret = rd_cmd_request_init(rd_interface, Cmd_TestEcho);
@@ -2291,17 +3207,56 @@ int Rd_TestEcho(RD_INTERFACE* rd_interface, const char* label, char** output)
     {
         return ret;
     }
-    ret = rd_cmd_response_receive(rd_interface);
+    return rd_cmd_response_receive(rd_interface);
+}
+
+/* ================================================================== */
+/* Rd_TestEchoView */
+int Rd_TestEchoView(RD_INTERFACE* rd_interface, const char* label, const char** data, int* length)
+{
+    int ret;
+    ret = rd_test_echo_request(rd_interface, label);
     if (ret < 0)
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_data(rd_interface, 8, output);
+    /* data length is the word after the status, data starts behind it */
+    return rd_cmd_response_check_and_get_view(rd_interface, RD_PROTO_POS_DATA, data, length);
 }
 
 /* ================================================================== */
-/* Rd_SystemInfo */
-int Rd_SystemInfo(RD_INTERFACE* rd_interface, RD_GET_VERSION_TYPE type, char** output)
+/* Rd_TestEchoCopy */
+int Rd_TestEchoCopy(RD_INTERFACE* rd_interface, const char* label, char* buffer, int buffer_size, int* length)
+{
+    int ret;
+    const char* data;
+    ret = Rd_TestEchoView(rd_interface, label, &data, length);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_data_copy(data, *length, buffer, buffer_size);
+}
+
+#ifndef RD_NO_HEAP
+/* ================================================================== */
+/* Rd_TestEcho */
+int Rd_TestEcho(RD_INTERFACE* rd_interface, const char* label, char** output)
+{
+    int ret, length;
+    const char* data;
+    ret = Rd_TestEchoView(rd_interface, label, &data, &length);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_data_allocate(data, length, output);
+}
+#endif
+
+/* ================================================================== */
+/* send system info request and wait for the reply */
+static int rd_system_info_request(RD_INTERFACE* rd_interface, RD_GET_VERSION_TYPE type)
 {
     int ret;
     ret = rd_cmd_request_init(rd_interface, Cmd_SystemInfo);
@@ -2319,17 +3274,56 @@ int Rd_SystemInfo(RD_INTERFACE* rd_interface, RD_GET_VERSION_TYPE type, char** o
     {
         return ret;
     }
-    ret = rd_cmd_response_receive(rd_interface);
+    return rd_cmd_response_receive(rd_interface);
+}
+
+/* ================================================================== */
+/* Rd_SystemInfoView */
+int Rd_SystemInfoView(RD_INTERFACE* rd_interface, RD_GET_VERSION_TYPE type, const char** data, int* length)
+{
+    int ret;
+    ret = rd_system_info_request(rd_interface, type);
     if (ret < 0)
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_data(rd_interface, 8, output);
+    /* data length is the word after the status, data starts behind it */
+    return rd_cmd_response_check_and_get_view(rd_interface, RD_PROTO_POS_DATA, data, length);
 }
 
 /* ================================================================== */
-/* Rd_EventMessage */
-int Rd_EventMessage(RD_INTERFACE* rd_interface, RD_EVENT** event, RD_UWORD* count)
+/* Rd_SystemInfoCopy */
+int Rd_SystemInfoCopy(RD_INTERFACE* rd_interface, RD_GET_VERSION_TYPE type, char* buffer, int buffer_size, int* length)
+{
+    int ret;
+    const char* data;
+    ret = Rd_SystemInfoView(rd_interface, type, &data, length);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_data_copy(data, *length, buffer, buffer_size);
+}
+
+#ifndef RD_NO_HEAP
+/* ================================================================== */
+/* Rd_SystemInfo */
+int Rd_SystemInfo(RD_INTERFACE* rd_interface, RD_GET_VERSION_TYPE type, char** output)
+{
+    int ret, length;
+    const char* data;
+    ret = Rd_SystemInfoView(rd_interface, type, &data, &length);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_data_allocate(data, length, output);
+}
+#endif
+
+/* ================================================================== */
+/* send event message request and wait for the reply */
+static int rd_event_message_request(RD_INTERFACE* rd_interface)
 {
     int ret;
     ret = rd_cmd_request_init(rd_interface, Cmd_EventMessage);
@@ -2342,13 +3336,36 @@ int Rd_EventMessage(RD_INTERFACE* rd_interface, RD_EVENT** event, RD_UWORD* coun
     {
         return ret;
     }
-    ret = rd_cmd_response_receive(rd_interface);
+    return rd_cmd_response_receive(rd_interface);
+}
+
+/* ================================================================== */
+/* Rd_EventMessageView */
+int Rd_EventMessageView(RD_INTERFACE* rd_interface, RD_EVENT* event, int capacity, RD_UWORD* count)
+{
+    int ret;
+    ret = rd_event_message_request(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    return rd_cmd_response_check_and_get_event_view(rd_interface, event, capacity, 8, count);
+}
+
+#ifndef RD_NO_HEAP
+/* ================================================================== */
+/* Rd_EventMessage */
+int Rd_EventMessage(RD_INTERFACE* rd_interface, RD_EVENT** event, RD_UWORD* count)
+{
+    int ret;
+    ret = rd_event_message_request(rd_interface);
     if (ret < 0)
     {
         return ret;
     }
     return rd_cmd_response_check_and_get_event_data(rd_interface, event, 8, count);
 }
+#endif
 
 /* ================================================================== */
 /* Rd_FlashWriteEnable */
@@ -2416,32 +3433,54 @@ int Rd_FlashImage(RD_INTERFACE* rd_interface, RD_UWORD type, const char* filenam
 int Rd_FlashData(RD_INTERFACE* rd_interface, RD_ID transfer_id, RD_UWORD type, const char* data)
 {
     int ret;
-    ret = rd_cmd_request_init(rd_interface, Cmd_FlashData);
-    if (ret < 0)
-    {
-        return ret;
-    }
-    ret = rd_cmd_request_append_uword(rd_interface, transfer_id);
-    if (ret < 0)
-    {
-        return ret;
-    }
-    ret = rd_cmd_request_append_uword(rd_interface, type);
-    if (ret < 0)
-    {
-        return ret;
-    }
-    ret = rd_cmd_request_append_string(rd_interface, data);
-    if (ret < 0)
-    {
-        return ret;
-    }
-    ret = rd_cmd_request_process(rd_interface);
-    if (ret < 0)
+    int len, max_len, chunk_len, sent;
+
+    /* transfer id, type and data length precede the data */
+    max_len = RD_MAX_PAYLOAD - 3 * 2;
+    len = strlen(data);
+    sent = 0;
+    do
     {
-        return ret;
+        chunk_len = (len - sent < max_len) ? len - sent : max_len;
+        ret = rd_cmd_request_init(rd_interface, Cmd_FlashData);
+        if (ret < 0)
+        {
+            break;
+        }
+        ret = rd_cmd_request_append_uword(rd_interface, transfer_id);
+        if (ret < 0)
+        {
+            break;
+        }
+        ret = rd_cmd_request_append_uword(rd_interface, type);
+        if (ret < 0)
+        {
+            break;
+        }
+        ret = rd_cmd_request_append_data(rd_interface, data + sent, chunk_len);
+        if (ret < 0)
+        {
+            break;
+        }
+        ret = rd_cmd_request_process(rd_interface);
+        if (ret < 0)
+        {
+            break;
+        }
+        sent += chunk_len;
+        if (sent >= len)
+        {
+            return rd_cmd_response_receive(rd_interface);
+        }
+        ret = rd_cmd_response_defer(rd_interface);
+        if (ret < 0)
+        {
+            return ret;
+        }
     }
-    return rd_cmd_response_receive(rd_interface);
+    while (sent < len);
+    rd_cmd_response_drain(rd_interface);
+    return ret;
 }
 
 /* ================================================================== */
@@ -2533,7 +3572,14 @@ int Rd_GetBackLightBrightness(RD_INTERFACE* rd_interface, RD_UWORD* backlight_br
     {
         return ret;
     }
-    return rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, backlight_brightness);
+    ret = rd_cmd_response_check_and_get_uword(rd_interface, RD_PROTO_POS_BYTE_1, backlight_brightness);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    rd_interface->state.backlight = *backlight_brightness;
+    rd_interface->state.has_backlight = !rd_interface->state.disabled && !rd_interface->broadcast;
+    return 0;
 }
 
 /* ================================================================== */
@@ -2541,6 +3587,21 @@ int Rd_GetBackLightBrightness(RD_INTERFACE* rd_interface, RD_UWORD* backlight_br
 int Rd_SetBackLightBrightness(RD_INTERFACE* rd_interface, RD_UWORD backlight_brightness)
 {
     int ret;
+    RD_STATE_CACHE* state;
+    _RD_CHECK_INTERFACE();
+
+    state = &rd_interface->state;
+    if (!state->disabled && !rd_interface->broadcast)
+    {
+        /* already in effect */
+        if (state->has_backlight && state->backlight == backlight_brightness)
+        {
+            state->elided++;
+            return 0;
+        }
+        /* unknown until the device accepted it */
+        state->has_backlight = 0;
+    }
     ret = rd_cmd_request_init(rd_interface, Cmd_SetBackLightBrightness);
     if (ret < 0)
     {
@@ -2556,7 +3617,18 @@ int Rd_SetBackLightBrightness(RD_INTERFACE* rd_interface, RD_UWORD backlight_bri
     {
         return ret;
     }
-    return rd_cmd_response_receive(rd_interface);
+    ret = rd_cmd_response_receive(rd_interface);
+    if (ret < 0)
+    {
+        return ret;
+    }
+    if (!state->disabled && !rd_interface->broadcast)
+    {
+        state->backlight = backlight_brightness;
+        state->has_backlight = 1;
+    }
+    /* device setting, not tied to a layer or page */
+    return rd_journal_update(rd_interface, RD_RESOURCE_ALL, 0);
 }
 
 
@@ -18,6 +18,13 @@
  *    - imageid is for storage of imageid from Rd_ImageLoad()
  *    - imagewrite_id is for storage of imagewrite_id from Rd_ImageWrite()
  * 
+ * usage: sampleloader [verbose] [port ...]
+ *    every port is a panel, all panels are loaded at the same time
+ *    default port is /dev/ttyACM0
+ *
+ * The state of every panel is saved in panel<n>.warm, a restart reattaches to
+ * a panel still showing the same image_list instead of resetting and loading it again.
+ * 
  */
 
 
@@ -27,61 +34,72 @@
 
 #define ENDLIST 0xff	/* End of list flag in layer field */
 
-int main(int argc, char **argv)
+/* load the image_list with the image name, layer, x position, y positon, imageid and imagewrite id, last two are uninitialzied */
+static struct image_object image_list[] =
+{
+	{"blue-off",		1,		0,0,		0,0},\
+	{"blue-on",		2,		0,150,		0,0},\
+	{"gold-button",		3,		0,300,		0,0},\
+	{"gray-off",		4,		0,450,		0,0},\
+	{"green-off",		5,		150,0,		0,0},\
+	{"pink-off",		6,		150,150,	0,0},\
+	{"red-off",		7,		150,300,	0,0},\
+	{"red-on",		7,		150,450,	0,0},\
+	{"button-lrb-blue",	7,		300,0,		0,0},\
+	{"button-lrb-green",	7,		300,150,	0,0},\
+	{"button-lrb-orange",	7,		300,300,	0,0},\
+	{"button-lrb-yellow",	7,		300,450,	0,0},\
+	{"blue-off",		1,		450,0,		0,0},\
+	{"blue-on",		2,		450,150,	0,0},\
+	{"gold-button",		3,		450,300,	0,0},\
+	{"gray-off",		4,		450,450,	0,0},\
+	{"green-off",		5,		600,0,		0,0},\
+	{"pink-off",		6,		600,150,	0,0},\
+	{"red-off",		7,		600,300,	0,0},\
+	{"red-on",		7,		600,450,	0,0},\
+	{"button-lrb-blue",	7,		750,0,		0,0},\
+	{"button-lrb-green",	7,		750,150,	0,0},\
+	{"button-lrb-orange",	7,		750,300,	0,0},\
+	{"button-lrb-yellow",	7,		750,450,	0,0},\
+	{"button-lrb-blue",	7,		900,0,		0,0},\
+	{"button-lrb-green",	7,		900,150,	0,0},\
+	{"button-lrb-orange",	7,		900,300,	0,0},\
+	{"button-lrb-yellow",	7,		900,450,	0,0},\
+	{"button-lrb-yellow",	7,		900,450,	0,0},\
+	{"STOP",ENDLIST,0,0,	0,0}     /* Setting layer = ENDLIST, denotes end of list this must be last entry in list */
+};
+
+#define IMAGE_COUNT (sizeof(image_list) / sizeof(image_list[0]))
+
+/* state of one panel, the ids of its images */
+static struct image_object panel_list[RD_GROUP_MAX_PANELS][IMAGE_COUNT];
+static int verbose = 0;
+
+/* build the scene on one panel, runs in the worker thread of the panel */
+static int loadpanel(RD_INTERFACE* rd_interface, int panel, void* context)
 {
 	int i;
 	int ret;
-	/* load the image_list with the image name, layer, x position, y positon, imageid and imagewrite id, last two are uninitialzied */
-	struct image_object image_list[] =
-	{
-		{"blue-off",		1,		0,0,		0,0},\
-		{"blue-on",		2,		0,150,		0,0},\
-		{"gold-button",		3,		0,300,		0,0},\
-		{"gray-off",		4,		0,450,		0,0},\
-		{"green-off",		5,		150,0,		0,0},\
-		{"pink-off",		6,		150,150,	0,0},\
-		{"red-off",		7,		150,300,	0,0},\
-		{"red-on",		7,		150,450,	0,0},\
-		{"button-lrb-blue",	7,		300,0,		0,0},\
-		{"button-lrb-green",	7,		300,150,	0,0},\
-		{"button-lrb-orange",	7,		300,300,	0,0},\
-		{"button-lrb-yellow",	7,		300,450,	0,0},\
-		{"blue-off",		1,		450,0,		0,0},\
-		{"blue-on",		2,		450,150,	0,0},\
-		{"gold-button",		3,		450,300,	0,0},\
-		{"gray-off",		4,		450,450,	0,0},\
-		{"green-off",		5,		600,0,		0,0},\
-		{"pink-off",		6,		600,150,	0,0},\
-		{"red-off",		7,		600,300,	0,0},\
-		{"red-on",		7,		600,450,	0,0},\
-		{"button-lrb-blue",	7,		750,0,		0,0},\
-		{"button-lrb-green",	7,		750,150,	0,0},\
-		{"button-lrb-orange",	7,		750,300,	0,0},\
-		{"button-lrb-yellow",	7,		750,450,	0,0},\
-		{"button-lrb-blue",	7,		900,0,		0,0},\
-		{"button-lrb-green",	7,		900,150,	0,0},\
-		{"button-lrb-orange",	7,		900,300,	0,0},\
-		{"button-lrb-yellow",	7,		900,450,	0,0},\
-		{"button-lrb-yellow",	7,		900,450,	0,0},\
-		{"STOP",ENDLIST,0,0,	0,0}     /* Setting layer = ENDLIST, denotes end of list this must be last entry in list */
-	};
-
-
-	/* RdInterfaceInit()
-	 *    Open port on host computer to Ripdraw display
-	 *    initialize Ripdraw library by creating a rd_interface handle
-	 */
-	RD_INTERFACE* rd_interface = RdInterfaceInit("/dev/ttyACM0");
+	char warm_file[32];
+	unsigned int fingerprint;
 
-	/* check if verbose is set from command line */
-	if (argc > 1)
+	(void) context;
+	rd_interface->verbose = verbose;
+	memcpy(panel_list[panel], image_list, sizeof(image_list));
+
+	/* skip reset and loading when the panel still shows this image_list */
+	sprintf(warm_file, "panel%d.warm", panel);
+	fingerprint = RD_WARM_FINGERPRINT_START;
+	for (i=0; image_list[i].image_layer != ENDLIST; i++)
 	{
-		rd_interface->verbose = atoi(argv[1]);
-		if (rd_interface->verbose < 0)
-		{
-			rd_interface->verbose = 0;
-		}
+		fingerprint = RdWarmFingerprint(fingerprint, image_list[i].image_name, (int) strlen(image_list[i].image_name) + 1);
+		fingerprint = RdWarmFingerprint(fingerprint, &image_list[i].image_layer, sizeof(int));
+		fingerprint = RdWarmFingerprint(fingerprint, &image_list[i].image_x, sizeof(int));
+		fingerprint = RdWarmFingerprint(fingerprint, &image_list[i].image_y, sizeof(int));
 	}
+	ret = RdWarmStartAttach(rd_interface, warm_file, fingerprint);
+	if (ret < 0) return ret;
+	if (ret == 1) return STATUS_OK;
 
 	/* Issue reset to Ripdraw display */
 	ret = Rd_Reset(rd_interface);
@@ -91,9 +109,9 @@ int main(int argc, char **argv)
 	do this for every element of the list
 	stop when element has image_layer = ENDLIST
 	*/
-	for (i=0; image_list[i].image_layer != ENDLIST; i++)
+	for (i=0; panel_list[panel][i].image_layer != ENDLIST; i++)
 	{
-		ret =enableloadwrite(rd_interface, image_list[i]);
+		ret =enableloadwrite(rd_interface, &panel_list[panel][i]);
 		if (ret != STATUS_OK) return ret;
 	}
 	
@@ -101,10 +119,53 @@ int main(int argc, char **argv)
 	ret = Rd_ComposeLayersToPage(rd_interface, 1);
 	if (ret != STATUS_OK) return ret;
 
-	/* close off the interface */
-	ret = RdInterfaceClose(rd_interface);
+	return RdWarmStartSave(rd_interface, warm_file, fingerprint);
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+	int ret;
+	int count = 1;
+	const char* ports[RD_GROUP_MAX_PANELS] = { "/dev/ttyACM0" };
+	RD_DISPLAY_GROUP group;
+
+	/* check if verbose is set from command line */
+	if (argc > 1)
+	{
+		verbose = atoi(argv[1]);
+		if (verbose < 0)
+		{
+			verbose = 0;
+		}
+	}
+	/* ports of the panels follow verbose */
+	if (argc > 2)
+	{
+		for (count = 0; count + 2 < argc && count < RD_GROUP_MAX_PANELS; count++)
+		{
+			ports[count] = argv[count + 2];
+		}
+	}
+
+	/* RdDisplayGroupOpen()
+	 *    Open ports on host computer to Ripdraw displays
+	 *    initialize Ripdraw library by creating a rd_interface handle per panel
+	 */
+	ret = RdDisplayGroupOpen(&group, ports, count);
+	if (ret != STATUS_OK) return ret;
+
+	/* load all panels concurrently */
+	ret = RdDisplayGroupRun(&group, loadpanel, NULL);
+	for (i = 0; i < group.count; i++)
+	{
+		printf("\nPanel %d (%s): %d", i, ports[i], group.panels[i].result);
+	}
+
+	/* close off the interfaces */
+	RdDisplayGroupClose(&group);
 
 	printf("\nRet: %d\n", ret);
 	printf("Done!\n");
-	return 0;
+	return ret;
 }